@@ -0,0 +1,27 @@
+#ifndef ATTACK_INFO_H
+#define ATTACK_INFO_H
+
+#include <cstdint>
+#include "piece.h"
+
+// Attack facts about a position, as square sets: bit i stands for square i.
+// Only what legality needs is kept, as the record is built at every node the
+// search visits. Board::attackInfo computes it on first use and keeps it
+// until the position changes, so move generation, check tests and the
+// search can all ask without scanning the board again.
+struct AttackInfo {
+    uint64_t enemyAttacks;  // squares the side not to move attacks
+    uint64_t checkers;      // pieces giving check to the side to move
+    uint64_t pinned;        // side to move's pieces pinned to its king
+    int kingSquare[2];      // by sideIndex; -1 when the side has no king
+};
+
+inline int sideIndex(int color) {
+    return color == Piece::White ? 0 : 1;
+}
+
+inline uint64_t squareBit(int square) {
+    return 1ULL << square;
+}
+
+#endif
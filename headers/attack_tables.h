@@ -0,0 +1,36 @@
+#ifndef ATTACK_TABLES_H
+#define ATTACK_TABLES_H
+
+#include <cstdint>
+
+// Rank and file steps of the eight line directions: straight ones first,
+// then diagonals. Rooks use the first four, bishops the last four, queens
+// all of them.
+constexpr int lineSteps[8][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+
+// Squares a knight or king on each square attacks, as square sets (bit i
+// stands for square i). Built at compile time; iterating a set visits the
+// squares in ascending order.
+struct StepAttackTable {
+    uint64_t knight[64];
+    uint64_t king[64];
+
+    constexpr StepAttackTable() : knight(), king() {
+        const int knightSteps[8][2] = {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}};
+        for (int square = 0; square < 64; square++) {
+            for (int i = 0; i < 8; i++) {
+                int r = square / 8 + knightSteps[i][0], f = square % 8 + knightSteps[i][1];
+                if (r >= 0 && r < 8 && f >= 0 && f < 8)
+                    knight[square] |= 1ULL << (r * 8 + f);
+                r = square / 8 + lineSteps[i][0];
+                f = square % 8 + lineSteps[i][1];
+                if (r >= 0 && r < 8 && f >= 0 && f < 8)
+                    king[square] |= 1ULL << (r * 8 + f);
+            }
+        }
+    }
+};
+
+inline constexpr StepAttackTable stepAttacks;
+
+#endif
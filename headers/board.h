@@ -3,34 +3,114 @@
 
 #include <vector>
 #include <string>
-#include <unordered_map>
-#include <sstream>
+#include <cstdint>
+#include <cstring>
 #include "piece.h"
 #include "move.h"
+#include "attack_info.h"
 
-class Board {
-public:
-    std::vector<int> board;
+class PerftTable;
+
+enum CastlingRight {
+    CastleWhiteKingside  = 1,
+    CastleWhiteQueenside = 2,
+    CastleBlackKingside  = 4,
+    CastleBlackQueenside = 8
+};
+
+// Keys of earlier positions kept for repetition detection, as a ring. A
+// repetition reaches back at most to the last capture or pawn move, and a
+// position 100 such plies on is drawn anyway, so this covers the game plus
+// the deepest search line.
+const int KEY_HISTORY_SIZE = 256;
+
+// Everything that describes a position. Small and trivially copyable, so it can
+// be snapshotted before a move and copied back instead of unmaking it.
+struct BoardState {
+    uint8_t board[64];
     int sideToMove;
-    bool canCastleKingsideWhite, canCastleQueensideWhite;
-    bool canCastleKingsideBlack, canCastleQueensideBlack;
+    int castlingRights;
     int enPassantTarget;
     int moveCount;
+    int halfmoveClock;
+    uint64_t zobristKey;
+};
 
+class Board : public BoardState {
+public:
     Board();
-    void fenPosition(const std::string& fen);
-    std::vector<Move> generatePawnMoves(int square, int color);
-    std::vector<Move> generateKnightMoves(int square, int color);
-    std::vector<Move> generateRookMoves(int square, int color);
-    std::vector<Move> generateBishopMoves(int square, int color);
-    std::vector<Move> generateQueenMoves(int square, int color);
-    std::vector<Move> generateKingMoves(int square, int color, bool canCastleK, bool canCastleQ);
-    bool isSquareAttacked(int square, int attackerColor);
-    bool isKingInCheck(int color);
+    // Returns false when a field is malformed; the position is still set up
+    // from what could be read.
+    bool fenPosition(const char* fen, size_t length);
+    bool fenPosition(const std::string& fen) {
+        return fenPosition(fen.data(), fen.size());
+    }
+    bool fenPosition(const char* fen) {
+        return fenPosition(fen, std::strlen(fen));
+    }
+    // Sets up the given position as the start of a new game; the key is recomputed.
+    void setState(const BoardState& state);
+    // Generators, attack tests and move execution are specialized on the
+    // side (Piece::White or Piece::Black) at compile time. The untemplated
+    // calls dispatch on sideToMove once and forward to them.
+    template<int Us> std::vector<Move> generatePawnMoves(int square);
+    template<int Us> std::vector<Move> generateKnightMoves(int square);
+    template<int Us> std::vector<Move> generateRookMoves(int square);
+    template<int Us> std::vector<Move> generateBishopMoves(int square);
+    template<int Us> std::vector<Move> generateQueenMoves(int square);
+    template<int Us> std::vector<Move> generateKingMoves(int square);
+    bool isSquareAttacked(int square, int attackerColor) const;
+    template<int Attacker> bool isSquareAttacked(int square) const;
+    bool isKingInCheck(int color) const;
+    template<int Us> bool isKingInCheck() const;
+    // Computed once per position, on first use; see attack_info.h.
+    const AttackInfo& attackInfo() const;
+    bool inCheck() const {
+        return attackInfo().checkers != 0;
+    }
+    int findKing(int color) const;
+    static int attackersTo(const uint8_t* squares, int square, int attackerColor, int* attackerSquares);
+    int attackersTo(int square, int attackerColor, int* attackerSquares) const {
+        return attackersTo(board, square, attackerColor, attackerSquares);
+    }
+    int staticExchange(const Move& move) const;
     std::vector<Move> generateLegalMoves();
+    template<int Us> std::vector<Move> generateLegalMoves();
+    // Captures only; the side to move must not be in check.
+    template<int Us> std::vector<Move> generateLegalCaptures();
+    template<int Us> std::vector<Move> generateEvasions(int kingSquare, const int* checkers, int checkerCount);
+    // Whether a move given by its squares and promotion piece is legal here.
+    bool isLegal(const Move& move);
+    template<int Us> bool isLegal(const Move& move);
+    // Plays a move for good, or until restoreState puts back a saved state.
     void makeMove(const Move& move);
-    void unmakeMove();
-    int moveGenerationTest(int depth);
+    template<int Us> void makeMove(const Move& move);
+    // Plays a move and fills in the record unmakeMove needs to take it back.
+    // The record is the caller's, one per ply, so the board keeps none.
+    void makeMove(const Move& move, MoveHistory& undo);
+    template<int Us> void makeMove(const Move& move, MoveHistory& undo);
+    void unmakeMove(const MoveHistory& undo);
+    // Us is the side that played the move being taken back.
+    template<int Us> void unmakeMove(const MoveHistory& undo);
+    // Copy-make counterpart of unmakeMove: copy back a state saved before makeMove.
+    void restoreState(const BoardState& state);
+    uint64_t moveGenerationTest(int depth);
+    template<int Us> uint64_t moveGenerationTest(int depth);
+    uint64_t perftHashed(int depth, PerftTable& table);
+    template<int Us> uint64_t perftHashed(int depth, PerftTable& table);
+    uint64_t computeZobristKey() const;
+    bool isRepetition() const {
+        return lastRepetition() >= 0;
+    }
+    // Index in the history of the same position's latest earlier
+    // occurrence, or -1. Positions count from the start of the game, the
+    // current one being historyLength().
+    int lastRepetition() const;
+    int historyLength() const {
+        return historyCount;
+    }
+    bool isThreefoldRepetition() const;
+    bool isFiftyMoveDraw() const;
     int getMoveCount() const {
         return moveCount;
     }
@@ -39,7 +119,21 @@ public:
     
 
 private:
-    std::vector<MoveHistory> moveHistoryStack;
+    template<int Us> bool leavesKingInCheck(const Move& move);
+    template<int Us> std::vector<Move> generatePieceMoves(int square);
+
+    // Keys of the positions before each move played, the one before move i
+    // at keyHistory[i % KEY_HISTORY_SIZE]. Preallocated inline, so makeMove
+    // never allocates and copying a Board is a flat memcpy.
+    uint64_t keyHistory[KEY_HISTORY_SIZE];
+    int historyCount;
+
+    // Cached attack record, dropped whenever the position changes. Code
+    // that edits board[] directly must not ask for it until the squares are
+    // put back.
+    void computeAttackInfo() const;
+    mutable AttackInfo attacks;
+    mutable bool attacksValid;
 };
 
 #endif
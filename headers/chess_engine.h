@@ -0,0 +1,137 @@
+#ifndef CHESS_ENGINE_H
+#define CHESS_ENGINE_H
+
+/*
+ * The engine as a library (libchessengine.a / libchessengine.so), for
+ * programs that would rather call it than talk UCI to a child process.
+ * Plain C, so the interface stays stable whatever changes inside.
+ *
+ * A ChessEngine holds one position and its own transposition table. Use a
+ * handle from one thread at a time; chess_engine_stop is the exception and
+ * may be called from any thread while chess_engine_search runs.
+ *
+ * Scores are in centipawns from White's side. Squares count from a8 = 0 to
+ * h1 = 63, rank by rank.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define CHESS_API __attribute__((visibility("default")))
+#else
+#define CHESS_API
+#endif
+
+/* Bumped whenever a declaration below changes incompatibly. */
+#define CHESS_ENGINE_API_VERSION 1
+
+/* More moves than any position has. */
+#define CHESS_MAX_MOVES 256
+#define CHESS_MAX_PV 65
+
+enum ChessStatus {
+    CHESS_OK = 0,
+    CHESS_ERROR_INVALID_FEN = -1,
+    CHESS_ERROR_ILLEGAL_MOVE = -2,
+    CHESS_ERROR_NO_LEGAL_MOVES = -3,
+    CHESS_ERROR_ARGUMENT = -4
+};
+
+typedef struct ChessEngine ChessEngine;
+
+typedef struct ChessMove {
+    int from;
+    int to;
+    char promotion;     /* 'q', 'r', 'b', 'n', or 0 */
+    char uci[6];        /* "e2e4", "a7a8q", null-terminated */
+} ChessMove;
+
+/* Zero means unset. With nothing set the search runs until
+   chess_engine_stop is called or it reaches its depth limit. */
+typedef struct ChessSearchLimits {
+    int depth;
+    long long nodes;
+    int move_time_ms;
+    int white_time_ms;
+    int black_time_ms;
+    int white_increment_ms;
+    int black_increment_ms;
+    int moves_to_go;
+    int multipv;        /* lines reported per iteration; 0 means 1 */
+} ChessSearchLimits;
+
+/* One line of a finished iteration. pv points into the engine and is only
+   valid during the callback. */
+typedef struct ChessSearchInfo {
+    int depth;
+    int multipv;
+    int score;
+    long long nodes;
+    long long time_ms;
+    int pv_length;
+    const ChessMove* pv;
+} ChessSearchInfo;
+
+typedef void (*ChessProgressCallback)(const ChessSearchInfo* info, void* user_data);
+
+enum ChessMateStatus {
+    CHESS_MATE_FOUND = 0,
+    CHESS_MATE_NONE = 1,        /* proven: no mate within the moves asked */
+    CHESS_MATE_UNKNOWN = 2      /* stopped or out of nodes or time first */
+};
+
+typedef struct ChessMateResult {
+    int status;
+    int mate_in;                /* moves, when found */
+    int line_length;
+    ChessMove line[CHESS_MAX_PV];
+    long long nodes;
+} ChessMateResult;
+
+typedef struct ChessSearchResult {
+    ChessMove best_move;
+    ChessMove ponder_move;  /* uci is "0000" when there is none */
+    int score;
+} ChessSearchResult;
+
+CHESS_API int chess_engine_api_version(void);
+
+/* hash_mb sizes the transposition table; 0 picks the default. */
+CHESS_API ChessEngine* chess_engine_new(int hash_mb);
+CHESS_API void chess_engine_free(ChessEngine* engine);
+/* Forgets earlier games: empties the table and sets up the start position. */
+CHESS_API void chess_engine_new_game(ChessEngine* engine);
+
+/* Sets up fen, or the start position when fen is NULL, then plays moves, a
+   space-separated list of UCI moves that may be NULL. On error the position
+   is left as it was. */
+CHESS_API int chess_engine_set_position(ChessEngine* engine, const char* fen, const char* moves);
+CHESS_API int chess_engine_make_move(ChessEngine* engine, const char* uci);
+
+/* Fills moves (room for CHESS_MAX_MOVES) and returns how many there are. */
+CHESS_API int chess_engine_legal_moves(ChessEngine* engine, ChessMove* moves);
+CHESS_API int chess_engine_in_check(ChessEngine* engine);
+CHESS_API int chess_engine_evaluate(ChessEngine* engine);
+
+/* Searches the current position. progress may be NULL. Returns
+   CHESS_ERROR_NO_LEGAL_MOVES on mate or stalemate. */
+CHESS_API int chess_engine_search(ChessEngine* engine, const ChessSearchLimits* limits,
+                                  ChessProgressCallback progress, void* user_data,
+                                  ChessSearchResult* result);
+/* Looks for a forced mate by the side to move within moves of its moves,
+   with a proof-number search; the shortest is reported with its line.
+   limits may be NULL; depth and multipv do not apply, and the clock
+   fields are budgeted as for chess_engine_search. table_mb bounds the
+   solver's memory, 0 picks the default. */
+CHESS_API int chess_engine_find_mate(ChessEngine* engine, int moves, const ChessSearchLimits* limits,
+                                     int table_mb, ChessMateResult* result);
+/* Stops a running chess_engine_search or chess_engine_find_mate. */
+CHESS_API void chess_engine_stop(ChessEngine* engine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
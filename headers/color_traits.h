@@ -0,0 +1,32 @@
+#ifndef COLOR_TRAITS_H
+#define COLOR_TRAITS_H
+
+#include "piece.h"
+#include "board.h"
+
+// Everything about a side that move generation and move execution would
+// otherwise branch on, as compile-time constants. Us is Piece::White or
+// Piece::Black.
+template<int Us> struct ColorTraits;
+
+template<> struct ColorTraits<Piece::White> {
+    static constexpr int Them = Piece::Black;
+    static constexpr int Forward = -8;     // square offset of a single pawn push
+    static constexpr int StartRank = 6;    // rank of pawns that may push twice
+    static constexpr int PromotionRank = 0;
+    static constexpr int BackRank = 7;     // rank the king and rooks start on
+    static constexpr int KingsideCastle = CastleWhiteKingside;
+    static constexpr int QueensideCastle = CastleWhiteQueenside;
+};
+
+template<> struct ColorTraits<Piece::Black> {
+    static constexpr int Them = Piece::White;
+    static constexpr int Forward = 8;
+    static constexpr int StartRank = 1;
+    static constexpr int PromotionRank = 7;
+    static constexpr int BackRank = 0;
+    static constexpr int KingsideCastle = CastleBlackKingside;
+    static constexpr int QueensideCastle = CastleBlackQueenside;
+};
+
+#endif
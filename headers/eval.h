@@ -3,10 +3,25 @@
 
 #include "board.h"
 
+// Every number the evaluation uses. The defaults come from eval_tables.h;
+// the tuner (tools/tune.cpp) adjusts a copy and writes that file back out.
+struct EvalParams {
+    int pieceValue[7];          // indexed by Piece::Type
+    int pieceSquare[7][64];     // from White's side; Black reads square ^ 56
+    int centerPawnBonus;
+};
+
 class Evaluator {
 public:
     static int evaluate(const Board& board);
+    static int evaluate(const Board& board, const EvalParams& params);
+    static const EvalParams& defaultParams();
+
+    // Early-game plies during which centre pawns earn centerPawnBonus.
+    static const int OPENING_PLIES = 20;
 
+    // Nominal piece values, used where a fixed scale is needed (exchange
+    // evaluation, mate scores) rather than by the evaluation itself.
     static const int PAWN_VALUE = 100;
     static const int KNIGHT_VALUE = 320;
     static const int BISHOP_VALUE = 330;
@@ -0,0 +1,57 @@
+#ifndef EVAL_BATCH_H
+#define EVAL_BATCH_H
+
+#include <cstdint>
+#include <vector>
+#include "board.h"
+#include "eval.h"
+
+// Many unrelated positions stored square by square in blocks of eight: a
+// block holds one row of eight piece bytes per square, so the same square
+// of eight positions loads as one word. Evaluating the batch gives exactly
+// Evaluator::evaluate for each position, a block per step on CPUs with AVX2
+// and one position at a time elsewhere.
+class EvalBatch {
+public:
+    // Positions per block.
+    static const int BLOCK = 8;
+
+    explicit EvalBatch(int capacity);
+
+    void clear() { count = 0; }
+    // Returns the position's index, or -1 when the batch is full.
+    int add(const Board& board);
+    int size() const { return count; }
+    int capacity() const { return maxCount; }
+    uint8_t pieceCode(int square, int index) const {
+        return pieces[(index / BLOCK * 64 + square) * BLOCK + index % BLOCK];
+    }
+
+    // scores must have room for size() values.
+    void evaluate(int* scores) const;
+    void evaluate(const EvalParams& params, int* scores) const;
+    // The portable kernel, whatever the CPU supports.
+    void evaluateScalar(const EvalParams& params, int* scores) const;
+
+    static bool hasAVX2();
+
+    // Signed score of every piece code on every square. Codes use five
+    // bits; the sixth selects the opening table, which adds the centre pawn
+    // bonus.
+    struct Table {
+        int32_t values[64][64];
+    };
+    static void buildTable(const EvalParams& params, Table& table);
+
+private:
+    void evaluateAVX2(const Table& table, int* scores) const;
+    void evaluateScalar(const Table& table, int* scores) const;
+
+    int maxCount;
+    int count;
+    std::vector<uint8_t> pieces;
+    // 32 for positions still in the opening, 0 after; added to the codes.
+    std::vector<uint8_t> phase;
+};
+
+#endif
@@ -0,0 +1,88 @@
+// Evaluation tables, indexed by Piece::Type. Piece-square values are given
+// from White's side (square 0 is a8); Black's pieces read them mirrored.
+//
+// Written by tools/tune.cpp; regenerate with the tuner instead of editing.
+// Source: the original hand-written evaluation.
+
+#ifndef EVAL_TABLES_H
+#define EVAL_TABLES_H
+
+const int EVAL_PIECE_VALUES[7] = {0, 20000, 100, 320, 330, 500, 900};
+
+const int EVAL_PIECE_SQUARE[7][64] = {
+    { // None
+           0,    0,    0,    0,    0,    0,    0,    0,
+           0,    0,    0,    0,    0,    0,    0,    0,
+           0,    0,    0,    0,    0,    0,    0,    0,
+           0,    0,    0,    0,    0,    0,    0,    0,
+           0,    0,    0,    0,    0,    0,    0,    0,
+           0,    0,    0,    0,    0,    0,    0,    0,
+           0,    0,    0,    0,    0,    0,    0,    0,
+           0,    0,    0,    0,    0,    0,    0,    0
+    },
+    { // King
+           0,    0,    0,    0,    0,    0,    0,    0,
+           0,    0,    0,    0,    0,    0,    0,    0,
+           0,    0,    0,    0,    0,    0,    0,    0,
+           0,    0,    0,    0,    0,    0,    0,    0,
+           0,    0,    0,    0,    0,    0,    0,    0,
+           0,    0,    0,    0,    0,    0,    0,    0,
+           0,    0,    0,    0,    0,    0,    0,    0,
+           0,    0,    0,    0,    0,    0,    0,    0
+    },
+    { // Pawn
+           0,    0,    1,    1,    1,    1,    0,    0,
+           0,    1,    1,    2,    2,    1,    1,    0,
+           1,    1,    2,    2,    2,    2,    1,    1,
+           1,    2,    2,    3,    3,    2,    2,    1,
+           1,    2,    2,    3,    3,    2,    2,    1,
+           1,    1,    2,    2,    2,    2,    1,    1,
+           0,    1,    1,    2,    2,    1,    1,    0,
+           0,    0,    1,    1,    1,    1,    0,    0
+    },
+    { // Knight
+           3,    5,    7,    9,    9,    7,    5,    3,
+           5,    7,    9,   11,   11,    9,    7,    5,
+           7,    9,   11,   13,   13,   11,    9,    7,
+           9,   11,   13,   15,   15,   13,   11,    9,
+           9,   11,   13,   15,   15,   13,   11,    9,
+           7,    9,   11,   13,   13,   11,    9,    7,
+           5,    7,    9,   11,   11,    9,    7,    5,
+           3,    5,    7,    9,    9,    7,    5,    3
+    },
+    { // Bishop
+           5,    7,    9,   11,   11,    9,    7,    5,
+           7,    9,   11,   13,   13,   11,    9,    7,
+           9,   11,   13,   15,   15,   13,   11,    9,
+          11,   13,   15,   17,   17,   15,   13,   11,
+          11,   13,   15,   17,   17,   15,   13,   11,
+           9,   11,   13,   15,   15,   13,   11,    9,
+           7,    9,   11,   13,   13,   11,    9,    7,
+           5,    7,    9,   11,   11,    9,    7,    5
+    },
+    { // Rook
+           0,    1,    2,    3,    3,    2,    1,    0,
+           1,    2,    3,    4,    4,    3,    2,    1,
+           2,    3,    4,    5,    5,    4,    3,    2,
+           3,    4,    5,    6,    6,    5,    4,    3,
+           3,    4,    5,    6,    6,    5,    4,    3,
+           2,    3,    4,    5,    5,    4,    3,    2,
+           1,    2,    3,    4,    4,    3,    2,    1,
+           0,    1,    2,    3,    3,    2,    1,    0
+    },
+    { // Queen
+           0,    1,    2,    3,    3,    2,    1,    0,
+           1,    2,    3,    4,    4,    3,    2,    1,
+           2,    3,    4,    5,    5,    4,    3,    2,
+           3,    4,    5,    6,    6,    5,    4,    3,
+           3,    4,    5,    6,    6,    5,    4,    3,
+           2,    3,    4,    5,    5,    4,    3,    2,
+           1,    2,    3,    4,    4,    3,    2,    1,
+           0,    1,    2,    3,    3,    2,    1,    0
+    }
+};
+
+// For each d- or e-pawn off its start square during the first 20 plies.
+const int EVAL_CENTER_PAWN_BONUS = 20;
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef MATE_SEARCH_H
+#define MATE_SEARCH_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "board.h"
+#include "move.h"
+#include "search.h"
+
+// Proof and disproof numbers of positions already looked at, keyed by
+// position and the plies left. Buckets of four; when a bucket is full the
+// entry that cost the least work to compute is replaced.
+class MateTable {
+public:
+    explicit MateTable(int sizeMB = 64);
+
+    void resize(int sizeMB);
+    void clear();
+    bool probe(uint64_t key, int remaining, uint32_t& proof, uint32_t& disproof) const;
+    void store(uint64_t key, int remaining, uint32_t proof, uint32_t disproof, uint64_t work);
+
+private:
+    static const int BUCKET_SIZE = 4;
+
+    struct Entry {
+        uint64_t key;
+        uint32_t proof;
+        uint32_t disproof;
+        uint32_t work;
+        int remaining;  // -1 for an empty entry
+    };
+
+    std::vector<Entry> entries;
+    uint64_t mask;  // selects a bucket
+};
+
+enum MateStatus {
+    MATE_FOUND,
+    MATE_NONE,      // proven: no mate within the asked number of moves
+    MATE_UNKNOWN    // stopped, or ran out of nodes or time first
+};
+
+// Answers "go mate N" with a depth-first proof-number search (df-pn): the
+// side to move tries to force mate within N of its own moves. Each
+// position's proof number estimates how many positions remain to be shown
+// mated, its disproof number how many to show it escapes, and the search
+// always expands the most promising one. Mates are tried at 1, 2, ... N
+// moves so the reported mate is the shortest. Draws by repetition or the
+// fifty-move rule are not considered.
+class MateSearch {
+public:
+    // The time limits, budgeted as Search does, nodes and infinite bound
+    // the search; so do stop() and the table size.
+    MateSearch(Board& board, int moves, const SearchLimits& limits, int tableMB = 64);
+
+    MateStatus solve();
+    // After MATE_FOUND: the mating line, and mate in how many moves.
+    const std::vector<Move>& getLine() const { return line; }
+    int getMateMoves() const { return mateMoves; }
+    // The line's first move, or else the move closest to a proof.
+    Move getBestMove() const { return bestMove; }
+    long long getNodes() const { return nodes; }
+
+    // Safe to call from another thread while solve is running.
+    void stop();
+    long long getTimeBudgetMs() const { return timeBudgetMs; }
+    void setOutput(const OutputSink& sink) { output = sink; }
+
+private:
+    void expand(int remaining, uint32_t proofThreshold, uint32_t disproofThreshold,
+                uint32_t& proof, uint32_t& disproof);
+    void lookup(int remaining, uint32_t& proof, uint32_t& disproof) const;
+    bool shouldStop();
+    bool isProven(int remaining);
+    int mateDistance(int maxRemaining);
+    void extractLine(int remaining);
+    Move mostPromisingMove(int remaining);
+    void emit(const std::string& text);
+
+    Board& board;
+    int maxMoves;
+    SearchLimits limits;
+    MateTable table;
+    OutputSink output;
+    int attacker;
+
+    long long timeBudgetMs;
+    long long startTimeMs;
+    std::atomic<bool> stopRequested;
+    // Signalled by stop, for an infinite search that has finished.
+    std::mutex waitLock;
+    std::condition_variable released;
+    bool aborted;
+    long long nodes;
+
+    std::vector<Move> line;
+    int mateMoves;
+    Move bestMove;
+};
+
+#endif
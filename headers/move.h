@@ -1,6 +1,7 @@
 #ifndef MOVE_H
 #define MOVE_H
 
+#include <cstdint>
 #include "piece.h"
 
 struct Move {
@@ -20,19 +21,14 @@ struct Move {
              isEnPassant(false), promotionPiece(Piece::None), isCastling(false) {}
 };
 
+// What makeMove overwrites and unmakeMove cannot work out from the move.
 struct MoveHistory {
     Move move;
-    int capturedPiece;           
-    int movedPiece;           
-    int oldEnPassant;         
-    bool oldCanCastleKingsideWhite;
-    bool oldCanCastleQueensideWhite;
-    bool oldCanCastleKingsideBlack;
-    bool oldCanCastleQueensideBlack;
-
-    int rookFrom = -1;
-    int rookTo = -1;
-    int rookPiece = Piece::None;
+    int capturedPiece;
+    int oldEnPassant;
+    int oldCastlingRights;
+    int oldHalfmoveClock;
+    uint64_t oldZobristKey;
 };
 
 #endif
\ No newline at end of file
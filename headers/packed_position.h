@@ -0,0 +1,48 @@
+#ifndef PACKED_POSITION_H
+#define PACKED_POSITION_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "board.h"
+
+// A scored training position in 32 bytes, independent of host byte order:
+//   0-7    occupancy, bit i set when square i holds a piece (little endian)
+//   8-23   one nibble per occupied square in square order, low nibble
+//          first: piece type, plus 8 for Black
+//   24     side to move (bit 0 set for Black) | castling rights << 1
+//   25     en passant square, or 64 for none; the square must be on the
+//          sixth rank with White to move and the third with Black
+//   26     halfmove clock (capped at 255)
+//   27-28  plies since the start of the game
+//   29-30  search score in centipawns from White's side
+//   31     game result in half points for White: 0, 1 or 2
+const int PACKED_POSITION_SIZE = 32;
+
+struct PackedPosition {
+    uint8_t bytes[PACKED_POSITION_SIZE];
+};
+
+void packPosition(const Board& board, int score, int result, PackedPosition& packed);
+// Fails on a record that does not describe a position.
+bool unpackPosition(const PackedPosition& packed, Board& board, int& score, int& result);
+
+// Streams records from a file in large blocks, decoding each straight into
+// the caller's Board.
+class PackedPositionReader {
+public:
+    explicit PackedPositionReader(const std::string& file);
+
+    bool isOpen() const { return in.is_open(); }
+    // Decodes the next valid record; false at the end of the file.
+    bool next(Board& board, int& score, int& result);
+
+private:
+    std::ifstream in;
+    std::vector<PackedPosition> block;
+    size_t blockSize;
+    size_t position;
+};
+
+#endif
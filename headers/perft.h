@@ -0,0 +1,28 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include <cstdint>
+#include <vector>
+
+// Node counts of already-counted subtrees, keyed by position and depth.
+class PerftTable {
+public:
+    explicit PerftTable(int sizeMB = 64);
+
+    void resize(int sizeMB);
+    void clear();
+    bool probe(uint64_t key, int depth, uint64_t& count) const;
+    void store(uint64_t key, int depth, uint64_t count);
+
+private:
+    struct Entry {
+        uint64_t key;
+        uint64_t count;
+        int depth;
+    };
+
+    std::vector<Entry> entries;
+    uint64_t mask;
+};
+
+#endif
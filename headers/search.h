@@ -1,25 +1,164 @@
 #ifndef SEARCH_H
 #define SEARCH_H
 
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include <string>
+#ifdef SEARCH_STATS
+#include <fstream>
+#endif
 #include "board.h"
 #include "move.h"
 #include "eval.h"
+#include "transposition.h"
+#include "search_stats.h"
+
+const int MAX_SEARCH_DEPTH = 64;
+
+// Receives engine output, one or more complete lines at a time.
+typedef std::function<void(const std::string&)> OutputSink;
+
+// Limits parsed from a UCI "go" command plus the search-related options.
+// Times are in milliseconds; zero means unset.
+struct SearchLimits {
+    int depth = MAX_SEARCH_DEPTH;
+    long long nodes = 0;
+    int moveTime = 0;
+    int whiteTime = 0, blackTime = 0;
+    int whiteIncrement = 0, blackIncrement = 0;
+    int movesToGo = 0;
+    bool infinite = false;
+    bool ponder = false;
+    // Number of principal variations to report (the MultiPV option).
+    int multiPV = 1;
+    // "go mate N": moves within which to look for a forced mate. Zero runs
+    // the normal search; see mate_search.h otherwise.
+    int mate = 0;
+    // Search::clockMs() time the move's clock started; zero means when the
+    // search starts. A search that queued for a worker is charged the wait.
+    long long startTimeMs = 0;
+#ifdef SEARCH_STATS
+    // JSON Lines file that receives the statistics after every iteration.
+    std::string statsTraceFile;
+#endif
+};
+
+// One line of a finished iteration, for callers that want it as data
+// rather than as an info line.
+struct SearchProgress {
+    int depth;
+    int multiPV;        // 1 for the best line
+    int score;          // from White's side
+    long long nodes;
+    long long timeMs;
+    const Move* pv;
+    int pvLength;
+};
+
+typedef std::function<void(const SearchProgress&)> ProgressSink;
+
+struct RootMove {
+    Move move;
+    int score;
+    Move pv[MAX_SEARCH_DEPTH + 1];
+    int pvLength;
+};
 
 class Search {
 public:
+    // Depths below 1 are raised to 1, so that a legal move is always found.
     Search(Board& board, int depth);
+    Search(Board& board, const SearchLimits& limits, TranspositionTable* table = nullptr);
     Move findBestMove();
+    Move getPonderMove() const { return ponderMove; }
+    // Score of the best move from White's side, after findBestMove.
+    int getScore() const { return bestScore; }
+    // Time allowed for this move in milliseconds; 0 when only depth, nodes
+    // or a stop command end the search.
+    long long getTimeBudgetMs() const { return timeBudgetMs; }
+    // The budget limits give sideToMove: movetime, or else a share of its
+    // clock and increment; 0 when neither is set.
+    static long long timeBudget(const SearchLimits& limits, int sideToMove);
+
+    // Safe to call from another thread while findBestMove is running.
+    void stop();
+    void ponderHit();
+
+    // Where info lines go; standard output unless set.
+    void setOutput(const OutputSink& sink) { output = sink; }
+    // Called with every line reported after an iteration.
+    void setProgress(const ProgressSink& sink) { progress = sink; }
+    static long long clockMs();
 
 private:
-    int minimax(Board& board, int depth, int alpha, int beta, bool maximizingPlayer); 
+    // The tree search is specialized on the side to move, Us; White
+    // maximizes. The side is picked once at the root and alternates from there.
+    template<int Us> int minimax(Board& board, int depth, int ply, int alpha, int beta);
+    template<int Us> int quiescence(Board& board, int ply, int alpha, int beta);
     int evaluateBoard(Board& board);
-    bool isGameOver(Board& board);
+    template<int Us> int terminalScore(Board& board);
+    template<int Us> std::vector<Move> generateMoves(Board& board);
+    template<int Us> std::vector<Move> generateCaptures(Board& board);
+    static bool isCapture(const Move& move);
 
-    Move findBestMoveAtDepth(int currentDepth);
+    template<int Us> Move findBestMoveAtDepth(int currentDepth);
     int moveHeuristic(const Move& move);
+    void orderMoves(std::vector<Move>& moves, uint16_t hashMove);
 
-    Board& board; 
+    void startClock();
+    long long elapsedMs() const;
+    void emit(const std::string& text);
+    bool shouldStop();
+    void reportIteration(int currentDepth);
+    void initRootMoves();
+    Move ponderMoveFromTable(const Move& bestMove);
+
+    Board& board;
     int depth;
+    SearchLimits limits;
+    TranspositionTable* tt;
+    OutputSink output;
+    ProgressSink progress;
+
+    // Time budget for this move; only enforced once pondering has ended.
+    long long timeBudgetMs;
+    std::atomic<long long> startTimeMs;
+    std::atomic<bool> stopRequested;
+    std::atomic<bool> pondering;
+    // Signalled by stop and ponderHit, for a search that has finished while
+    // it may not report its move yet.
+    std::mutex waitLock;
+    std::condition_variable released;
+    bool aborted;
+    long long nodes;
+    // Positions before the root, and draws found that depend on them or on
+    // the fifty-move count; see minimax.
+    int rootHistory;
+    long long gameDraws;
+
+    // Root moves kept sorted by their latest score, best first; the first
+    // multiPV entries are the lines that get reported.
+    std::vector<RootMove> rootMoves;
+    Move ponderMove;
+    int bestScore;
+
+#ifndef COPY_MAKE
+    // Undo records of the moves on the current line, indexed by the ply
+    // they were played at; quiescence reaches twice the depth limit.
+    MoveHistory undoStack[MAX_SEARCH_DEPTH * 2];
+#endif
+
+    // Triangular principal variation table, indexed by ply.
+    Move pvTable[MAX_SEARCH_DEPTH + 1][MAX_SEARCH_DEPTH + 1];
+    int pvLength[MAX_SEARCH_DEPTH + 1];
+
+#ifdef SEARCH_STATS
+    SearchStats stats;
+    std::ofstream trace;
+#endif
 };
 
 #endif
@@ -0,0 +1,66 @@
+#ifndef SEARCH_STATS_H
+#define SEARCH_STATS_H
+
+// Search instrumentation. Build with "make STATS=1" to enable it; otherwise
+// every STATS_* macro expands to nothing and SearchStats is not compiled in.
+
+#ifdef SEARCH_STATS
+
+#include <chrono>
+#include <ostream>
+#include <string>
+
+const int STATS_MAX_PLY = 65;
+
+struct SearchStats {
+    long long nodesPerPly[STATS_MAX_PLY];
+    long long mainNodes;
+    long long leafNodes;
+    long long quiescenceNodes;
+    long long betaCutoffs;
+    long long firstMoveCutoffs;
+    long long ttProbes;
+    long long ttHits;
+    long long ttCutoffs;
+    long long drawCutoffs;
+    long long seePrunes;
+    long long checkExtensions;
+    long long moveGenCalls;
+    long long moveGenNs;
+    long long evalCalls;
+    long long evalNs;
+
+    SearchStats() { reset(); }
+    void reset();
+    void print(std::ostream& out) const;
+    // Appends one JSON object (a single line) describing the search so far.
+    void writeJson(std::ostream& out, int depth, long long elapsedMs) const;
+};
+
+class StatsTimer {
+public:
+    explicit StatsTimer(long long& target)
+        : target(target), start(std::chrono::steady_clock::now()) {}
+    ~StatsTimer() {
+        target += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    long long& target;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define STATS_INC(field) (stats.field++)
+#define STATS_INC_PLY(ply) (stats.nodesPerPly[(ply) < STATS_MAX_PLY ? (ply) : STATS_MAX_PLY - 1]++)
+#define STATS_TIME(field) StatsTimer statsTimer_##field(stats.field)
+
+#else
+
+#define STATS_INC(field) ((void)0)
+#define STATS_INC_PLY(ply) ((void)0)
+#define STATS_TIME(field) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <string>
+
+// Hosts many UCI sessions in one process, listening on a Unix domain socket.
+// Each line a client sends is "<session> <command>", and each line a session
+// prints comes back as "<session> <line>". One connection can therefore
+// carry any number of games, or a client can open a connection per game.
+// A session starts on its first command and ends with "<session> quit" or
+// when its connection closes. All sessions share the worker pool and one
+// transposition table of hashMB megabytes.
+int runServer(const std::string& socketPath, int threads, int hashMB);
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include "move.h"
+
+enum TTFlag {
+    TT_EXACT = 0,
+    TT_LOWER = 1,   // score is a lower bound (the search failed high)
+    TT_UPPER = 2    // score is an upper bound (the search failed low)
+};
+
+struct TTEntry {
+    uint64_t key;
+    int32_t score;
+    int8_t depth;
+    uint8_t flag;
+    uint16_t bestMove;  // from | to << 6 | promotionPiece << 12
+};
+
+// Slots hold two 64-bit words: the packed entry and the key xor'ed with it.
+// Searches on several threads can share one table without locking; a slot
+// torn by two concurrent writers no longer decodes to its key and reads as
+// a miss.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(int sizeMB = 16);
+
+    void resize(int sizeMB);
+    void clear();
+    bool probe(uint64_t key, TTEntry& entry) const;
+    void store(uint64_t key, int depth, int score, int flag, const Move& bestMove);
+
+    static uint16_t packMove(const Move& move);
+    static bool sameMove(uint16_t packed, const Move& move);
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> check;  // key ^ data
+        std::atomic<uint64_t> data;
+    };
+
+    static uint64_t packEntry(int score, int depth, int flag, uint16_t bestMove);
+
+    std::unique_ptr<Slot[]> slots;
+    uint64_t mask;
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef UCI_SESSION_H
+#define UCI_SESSION_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "board.h"
+#include "search.h"
+#include "mate_search.h"
+#include "transposition.h"
+#include "worker_pool.h"
+
+// One UCI conversation: its own board, options and search state. Commands
+// come in through handleCommand and every reply goes to the output sink, so
+// the same session serves standard input or a server connection. Searches
+// run on the worker pool, except infinite and ponder searches, which get a
+// thread of their own. The transposition table is either the session's own
+// or one shared by every session of a server. Commands never wait for a
+// search still queued behind other sessions: stopping one takes it back
+// from the pool and reports its move at once.
+class UciSession {
+public:
+    UciSession(const OutputSink& output, WorkerPool& pool, TranspositionTable* sharedTable = nullptr);
+    ~UciSession();
+
+    // Returns false once the session has been told to quit.
+    bool handleCommand(const std::string& line);
+    // End of input: a bounded search may still finish and report its move.
+    void endOfInput();
+
+private:
+    void startSearch(std::istringstream& iss);
+    void startMateSearch(const SearchLimits& limits);
+    void launch(long long deadline, bool openEnded, const std::function<void()>& job);
+    void reportBestMove(const Move& bestMove, const Move& ponderMove);
+    void finishSearch(bool stopNow);
+    void setOption(std::istringstream& iss);
+    void runPerft(int depth);
+
+    OutputSink output;
+    WorkerPool& pool;
+    std::unique_ptr<TranspositionTable> ownTable;
+    TranspositionTable* table;
+
+    Board board;
+    std::string lastPosition;
+    int multiPV;
+    // Size of the perft cache in MB; 0 runs the plain make/unmake perft.
+    int perftHashMB;
+    int mateHashMB;
+#ifdef SEARCH_STATS
+    std::string statsTraceFile;
+#endif
+
+    // The search owns the board until its job has reported the move.
+    std::unique_ptr<Search> activeSearch;
+    std::unique_ptr<MateSearch> activeMate;
+    bool searchOpenEnded;
+    bool searchRunning;
+    // A job on the pool, kept so that it can be taken back and run here.
+    std::function<void()> queuedJob;
+    uint64_t queuedJobId;
+    // Infinite and ponder searches run here instead of on the pool.
+    std::thread searchThread;
+    std::mutex searchLock;
+    std::condition_variable searchDone;
+};
+
+#endif
@@ -4,7 +4,29 @@
 #include <string>
 #include "move.h"
 
+class Board;
+
+// The standard starting position.
+extern const char* const START_FEN;
+
+// Longest UCI move ("e7e8q") plus the terminating null.
+const int UCI_MOVE_BUFFER_SIZE = 6;
+
 std::string squareToString(int square);
 std::string moveToUCI(const Move& move);
 
-#endif
\ No newline at end of file
+// Allocation-free variants: write into a caller-provided buffer.
+void writeSquare(int square, char* out);
+int writeMoveUCI(const Move& move, char* out);
+
+// Neither side can mate: no pawns, rooks or queens, and at most one minor
+// piece on the board.
+bool insufficientMaterial(const Board& board);
+
+// Decodes a UCI move such as "e2e4" or "a7a8q" against the current position,
+// filling in capture, en passant and castling flags from the board.
+bool parseUCIMove(const Board& board, const char* text, int length, Move& move);
+// As parseUCIMove, but also requires the move to be legal in board.
+bool parseLegalUCIMove(Board& board, const char* text, int length, Move& move);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// A fixed set of threads running submitted jobs. The job with the earliest
+// deadline runs first, so a game that is short on time is not stuck behind
+// a long analysis; equal deadlines run in submission order.
+class WorkerPool {
+public:
+    // Deadline of jobs that have none, such as depth-limited searches.
+    static const long long NO_DEADLINE = LLONG_MAX;
+
+    explicit WorkerPool(int threadCount);
+    // Runs the jobs still queued, then joins the threads.
+    ~WorkerPool();
+
+    // Returns an id for cancel.
+    uint64_t submit(long long deadline, const std::function<void()>& job);
+    // Takes back a job that has not started yet. Returns false once a
+    // worker has picked it up.
+    bool cancel(uint64_t id);
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> threads;
+    // Keyed by deadline, then submission order; the first job runs next.
+    std::map<std::pair<long long, uint64_t>, std::function<void()>> queue;
+    std::mutex lock;
+    std::condition_variable wake;
+    bool stopping;
+    uint64_t nextSequence;
+};
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+
+class Zobrist {
+public:
+    // Indexed by the raw piece code (type | color) and square.
+    static uint64_t pieceKeys[24][64];
+    // Indexed by the castling rights bitmask.
+    static uint64_t castlingKeys[16];
+    static uint64_t enPassantKeys[8];
+    static uint64_t sideKey;
+
+    static void init();
+};
+
+#endif
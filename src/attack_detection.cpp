@@ -1,45 +1,36 @@
 #include "../headers/board.h"
+#include "../headers/color_traits.h"
+#include "../headers/attack_tables.h"
 
-bool Board::isSquareAttacked(int square, int attackerColor) {
+bool Board::isSquareAttacked(int square, int attackerColor) const {
+    return (attackerColor == Piece::White) ? isSquareAttacked<Piece::White>(square)
+                                           : isSquareAttacked<Piece::Black>(square);
+}
 
-    // Pawn attacks
-    std::vector<int> pawnAttackSquares;
-    if (attackerColor == Piece::White) {
-        pawnAttackSquares = {square + 7, square + 9};
-    } else {
-        pawnAttackSquares = {square - 7, square - 9};
-    }
+template<int Attacker>
+bool Board::isSquareAttacked(int square) const {
+    const int attackerColor = Attacker;
+
+    // Pawn attacks come from one rank behind the attacker's direction of travel.
+    const int behind = -ColorTraits<Attacker>::Forward;
+    const int pawnAttackSquares[2] = {square + behind - 1, square + behind + 1};
     for (int attackerSquare : pawnAttackSquares) {
         if (attackerSquare < 0 || attackerSquare >= 64)
             continue;
         if (abs((attackerSquare % 8) - (square % 8)) != 1)
             continue;
-        int piece = board[attackerSquare];
-        if (piece != Piece::None &&
-            (piece & (Piece::White | Piece::Black)) == attackerColor &&
-            ((piece & 7) == Piece::Pawn))
+        if (board[attackerSquare] == (Piece::Pawn | attackerColor))
             return true;
     }
 
     // Knight attacks
-    std::vector<int> knightOffsets = {-17, -15, -10, -6, 6, 10, 15, 17};
-    for (int offset : knightOffsets) {
-        int target = square + offset;
-        if (target >= 0 && target < 64) {
-            int dx = abs((target % 8) - (square % 8));
-            int dy = abs((target / 8) - (square / 8));
-            if ((dx == 1 && dy == 2) || (dx == 2 && dy == 1)) {
-                int targetPiece = board[target];
-                if (targetPiece != Piece::None &&
-                    (targetPiece & attackerColor) &&
-                    ((targetPiece & 7) == Piece::Knight))
-                    return true;
-            }
-        }
+    for (uint64_t bits = stepAttacks.knight[square]; bits; bits &= bits - 1) {
+        if (board[__builtin_ctzll(bits)] == (Piece::Knight | attackerColor))
+            return true;
     }
 
     // Rook and Queen attacks (horizontal and vertical)
-    std::vector<int> rookDirs = {-8, 8, -1, 1};
+    static constexpr int rookDirs[4] = {-8, 8, -1, 1};
     for (int dir : rookDirs) {
         for (int step = 1;; step++) {
             int target = square + dir * step;
@@ -58,7 +49,7 @@ bool Board::isSquareAttacked(int square, int attackerColor) {
     }
 
     // Bishop and Queen attacks (diagonals)
-    std::vector<int> bishopDirs = {-9, -7, 7, 9};
+    static constexpr int bishopDirs[4] = {-9, -7, 7, 9};
     for (int dir : bishopDirs) {
         for (int step = 1;; step++) {
             int target = square + dir * step;
@@ -79,36 +70,174 @@ bool Board::isSquareAttacked(int square, int attackerColor) {
     }
 
     // King attacks
-    std::vector<int> kingDirs = {-9, -8, -7, -1, 1, 7, 8, 9};
-    for (int dir : kingDirs) {
-        int target = square + dir;
-        if (target >= 0 && target < 64) {
-            int dx = abs((target % 8) - (square % 8));
-            int dy = abs((target / 8) - (square / 8));
-            if (dx <= 1 && dy <= 1) {
-                int targetPiece = board[target];
-                if (targetPiece != Piece::None &&
-                    (targetPiece & attackerColor) &&
-                    ((targetPiece & 7) == Piece::King))
-                    return true;
-            }
-        }
+    for (uint64_t bits = stepAttacks.king[square]; bits; bits &= bits - 1) {
+        if (board[__builtin_ctzll(bits)] == (Piece::King | attackerColor))
+            return true;
     }
 
     return false;
 }
 
 // Find the king of a given color.
-bool Board::isKingInCheck(int color) {
-    int kingPos = -1;
+int Board::findKing(int color) const {
     for (int i = 0; i < 64; i++) {
-        if ((board[i] & 7) == Piece::King && (board[i] & (Piece::White | Piece::Black)) == color) {
-            kingPos = i;
+        if (board[i] == (Piece::King | color))
+            return i;
+    }
+    return -1;
+}
+
+bool Board::isKingInCheck(int color) const {
+    return (color == Piece::White) ? isKingInCheck<Piece::White>() : isKingInCheck<Piece::Black>();
+}
+
+template<int Us>
+bool Board::isKingInCheck() const {
+    int kingPos = findKing(Us);
+
+    if (kingPos == -1) return false;
+    return isSquareAttacked<ColorTraits<Us>::Them>(kingPos);
+}
+
+const AttackInfo& Board::attackInfo() const {
+    if (!attacksValid) {
+        computeAttackInfo();
+        attacksValid = true;
+    }
+    return attacks;
+}
+
+void Board::computeAttackInfo() const {
+    AttackInfo& info = attacks;
+    info.enemyAttacks = 0;
+    info.kingSquare[0] = info.kingSquare[1] = -1;
+    int enemy = sideToMove ^ (Piece::White | Piece::Black);
+
+    for (int square = 0; square < 64; square++) {
+        int piece = board[square];
+        if (piece == Piece::None)
+            continue;
+        int side = sideIndex(piece & (Piece::White | Piece::Black));
+        int type = piece & 7;
+        if (type == Piece::King)
+            info.kingSquare[side] = square;
+        // The side to move's own attacks are not needed.
+        if (!(piece & enemy))
+            continue;
+        int rank = square / 8, file = square % 8;
+        uint64_t& attacked = info.enemyAttacks;
+
+        if (type == Piece::Pawn) {
+            // White pawns head towards rank 0.
+            int r = (side == 0) ? rank - 1 : rank + 1;
+            if (r >= 0 && r < 8) {
+                if (file > 0)
+                    attacked |= squareBit(r * 8 + file - 1);
+                if (file < 7)
+                    attacked |= squareBit(r * 8 + file + 1);
+            }
+        } else if (type == Piece::Knight) {
+            attacked |= stepAttacks.knight[square];
+        } else if (type == Piece::King) {
+            attacked |= stepAttacks.king[square];
+        } else {
+            int first = (type == Piece::Bishop) ? 4 : 0;
+            int last = (type == Piece::Rook) ? 4 : 8;
+            for (int dir = first; dir < last; dir++) {
+                int dr = lineSteps[dir][0], df = lineSteps[dir][1];
+                for (int r = rank + dr, f = file + df; r >= 0 && r < 8 && f >= 0 && f < 8; r += dr, f += df) {
+                    attacked |= squareBit(r * 8 + f);
+                    if (board[r * 8 + f] != Piece::None)
+                        break;
+                }
+            }
+        }
+    }
+
+    // Checks and pins against the side to move.
+    info.checkers = 0;
+    info.pinned = 0;
+    int king = info.kingSquare[sideIndex(sideToMove)];
+    if (king == -1)
+        return;
+    int checkers[32];
+    int checkerCount = attackersTo(king, enemy, checkers);
+    for (int i = 0; i < checkerCount; i++)
+        info.checkers |= squareBit(checkers[i]);
+
+    // A piece of ours is pinned when it is the only one between the king
+    // and an enemy slider that moves along that line.
+    for (int dir = 0; dir < 8; dir++) {
+        int dr = lineSteps[dir][0], df = lineSteps[dir][1];
+        int slider = (dir < 4) ? Piece::Rook : Piece::Bishop;
+        int blocker = -1;
+        for (int r = king / 8 + dr, f = king % 8 + df; r >= 0 && r < 8 && f >= 0 && f < 8; r += dr, f += df) {
+            int piece = board[r * 8 + f];
+            if (piece == Piece::None)
+                continue;
+            if ((piece & sideToMove) && blocker == -1) {
+                blocker = r * 8 + f;
+                continue;
+            }
+            if (blocker != -1 && (piece & enemy) && ((piece & 7) == slider || (piece & 7) == Piece::Queen))
+                info.pinned |= squareBit(blocker);
             break;
         }
     }
+}
 
-    if (kingPos == -1) return false;
-    int enemyColor = (color == Piece::White) ? Piece::Black : Piece::White;
-    return isSquareAttacked(kingPos, enemyColor);
-}
\ No newline at end of file
+template bool Board::isSquareAttacked<Piece::White>(int) const;
+template bool Board::isSquareAttacked<Piece::Black>(int) const;
+template bool Board::isKingInCheck<Piece::White>() const;
+template bool Board::isKingInCheck<Piece::Black>() const;
+
+// Collects the squares of every piece of attackerColor that attacks square on
+// the given piece array. Sliders are traced through the array, so removing a
+// piece from a copy and asking again reveals the x-ray attacker behind it.
+int Board::attackersTo(const uint8_t* squares, int square, int attackerColor, int* attackerSquares) {
+    int count = 0;
+    int rank = square / 8, file = square % 8;
+
+    // Pawns attack diagonally forward, so look one rank towards their side.
+    int pawnRank = (attackerColor == Piece::White) ? rank + 1 : rank - 1;
+    if (pawnRank >= 0 && pawnRank < 8) {
+        for (int df : {-1, 1}) {
+            int f = file + df;
+            if (f < 0 || f >= 8)
+                continue;
+            int from = pawnRank * 8 + f;
+            if (squares[from] == (Piece::Pawn | attackerColor))
+                attackerSquares[count++] = from;
+        }
+    }
+
+    for (uint64_t bits = stepAttacks.knight[square]; bits; bits &= bits - 1) {
+        int from = __builtin_ctzll(bits);
+        if (squares[from] == (Piece::Knight | attackerColor))
+            attackerSquares[count++] = from;
+    }
+
+    for (uint64_t bits = stepAttacks.king[square]; bits; bits &= bits - 1) {
+        int from = __builtin_ctzll(bits);
+        if (squares[from] == (Piece::King | attackerColor))
+            attackerSquares[count++] = from;
+    }
+
+    // Sliders: the first piece met along each ray, if it moves that way.
+    for (int dir = 0; dir < 8; dir++) {
+        int dr = lineSteps[dir][0], df = lineSteps[dir][1];
+        bool diagonal = (dir >= 4);
+        for (int r = rank + dr, f = file + df; r >= 0 && r < 8 && f >= 0 && f < 8; r += dr, f += df) {
+            int piece = squares[r * 8 + f];
+            if (piece == Piece::None)
+                continue;
+            int type = piece & 7;
+            if ((piece & (Piece::White | Piece::Black)) == attackerColor &&
+                (type == Piece::Queen || type == (diagonal ? Piece::Bishop : Piece::Rook)))
+                attackerSquares[count++] = r * 8 + f;
+            break;
+        }
+    }
+
+    return count;
+}
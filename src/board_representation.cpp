@@ -1,6 +1,8 @@
 #include "../headers/board.h"
 #include <iostream>
 #include <random>
+#include <algorithm>
+#include <type_traits>
 
 /*
 +----+----+----+----+----+----+----+----+
@@ -22,7 +24,24 @@
 +----+----+----+----+----+----+----+----+
 */
 
-Board::Board() : board(64, Piece::None), sideToMove(Piece::White),
-              canCastleKingsideWhite(false), canCastleQueensideWhite(false),
-              canCastleKingsideBlack(false), canCastleQueensideBlack(false),
-              enPassantTarget(-1) {}
+static_assert(std::is_trivially_copyable<BoardState>::value,
+              "BoardState must stay a flat value type so it can be snapshotted with a plain copy");
+static_assert(std::is_trivially_copyable<Board>::value,
+              "Board must stay a flat value type so it can be cloned with a plain copy");
+
+Board::Board() : historyCount(0), attacksValid(false) {
+    std::fill(board, board + 64, Piece::None);
+    sideToMove = Piece::White;
+    castlingRights = 0;
+    enPassantTarget = -1;
+    moveCount = 0;
+    halfmoveClock = 0;
+    zobristKey = 0;
+}
+
+void Board::setState(const BoardState& state) {
+    static_cast<BoardState&>(*this) = state;
+    historyCount = 0;
+    zobristKey = computeZobristKey();
+    attacksValid = false;
+}
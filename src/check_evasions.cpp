@@ -0,0 +1,130 @@
+#include "../headers/board.h"
+#include "../headers/color_traits.h"
+
+namespace {
+
+bool isSlider(int piece) {
+    int type = piece & 7;
+    return type == Piece::Bishop || type == Piece::Rook || type == Piece::Queen;
+}
+
+template<int Us>
+void addPawnMove(std::vector<Move>& moves, int from, int to, int captured) {
+    bool promotes = (to / 8 == ColorTraits<Us>::PromotionRank);
+    if (promotes) {
+        for (int promo : {Piece::Queen, Piece::Rook, Piece::Bishop, Piece::Knight})
+            moves.push_back(Move(from, to, captured, true, false, promo, false));
+    } else {
+        moves.push_back(Move(from, to, captured, false, false, Piece::None, false));
+    }
+}
+
+}
+
+// Legal moves for a side in check. Only three kinds of move can answer a
+// check: stepping the king to a safe square, capturing the checker, or
+// blocking the line between a sliding checker and the king. Under double
+// check only the king can move. Candidates still get the pin test, but far
+// fewer of them reach it than with full pseudo-legal generation.
+template<int Us>
+std::vector<Move> Board::generateEvasions(int kingSquare, const int* checkers, int checkerCount) {
+    typedef ColorTraits<Us> Traits;
+    std::vector<Move> moves;
+    const int color = Us;
+    const int enemy = Traits::Them;
+    int kingRank = kingSquare / 8, kingFile = kingSquare % 8;
+
+    // King steps. The king is lifted off the board while testing, so a
+    // slider cannot hide behind it along the checking line.
+    int king = board[kingSquare];
+    board[kingSquare] = Piece::None;
+    for (int dr = -1; dr <= 1; dr++) {
+        for (int df = -1; df <= 1; df++) {
+            int r = kingRank + dr, f = kingFile + df;
+            if ((dr == 0 && df == 0) || r < 0 || r >= 8 || f < 0 || f >= 8)
+                continue;
+            int target = r * 8 + f;
+            if (board[target] != Piece::None && (board[target] & (Piece::White | Piece::Black)) == color)
+                continue;
+            if (!isSquareAttacked<enemy>(target))
+                moves.push_back(Move(kingSquare, target, board[target], false, false, Piece::None, false));
+        }
+    }
+    board[kingSquare] = king;
+
+    if (checkerCount > 1)
+        return moves;
+
+    // Squares where another piece can answer the check: the checker itself
+    // and, for a slider, every square between it and the king.
+    int checker = checkers[0];
+    int targets[8];
+    int targetCount = 0;
+    targets[targetCount++] = checker;
+    if (isSlider(board[checker])) {
+        int dr = (checker / 8 > kingRank) - (checker / 8 < kingRank);
+        int df = (checker % 8 > kingFile) - (checker % 8 < kingFile);
+        for (int r = kingRank + dr, f = kingFile + df; r * 8 + f != checker; r += dr, f += df)
+            targets[targetCount++] = r * 8 + f;
+    }
+
+    std::vector<Move> candidates;
+    int pieces[32];
+    const int forward = Traits::Forward;
+    for (int t = 0; t < targetCount; t++) {
+        int target = targets[t];
+        bool isCapture = (target == checker);
+
+        // Pieces that attack the square can move there; pawns only when capturing.
+        int count = attackersTo(target, color, pieces);
+        for (int i = 0; i < count; i++) {
+            int from = pieces[i];
+            int type = board[from] & 7;
+            if (type == Piece::King)
+                continue;
+            if (type == Piece::Pawn) {
+                if (isCapture)
+                    addPawnMove<Us>(candidates, from, target, board[target]);
+                continue;
+            }
+            candidates.push_back(Move(from, target, board[target], false, false, Piece::None, false));
+        }
+
+        // Pawn pushes onto an empty blocking square.
+        if (!isCapture) {
+            int from = target - forward;
+            if (from >= 0 && from < 64) {
+                if (board[from] == (Piece::Pawn | color)) {
+                    addPawnMove<Us>(candidates, from, target, Piece::None);
+                } else if (board[from] == Piece::None) {
+                    int doubleFrom = from - forward;
+                    if (doubleFrom / 8 == Traits::StartRank && board[doubleFrom] == (Piece::Pawn | color))
+                        candidates.push_back(Move(doubleFrom, target, Piece::None, false, false, Piece::None, false));
+                }
+            }
+        }
+    }
+
+    // A pawn that just gave check with a double push can be taken en passant.
+    if (enPassantTarget != -1 && board[checker] == (Piece::Pawn | enemy) &&
+        enPassantTarget - forward == checker) {
+        int epFile = enPassantTarget % 8;
+        for (int df : {-1, 1}) {
+            int f = epFile + df;
+            if (f < 0 || f >= 8)
+                continue;
+            int from = checker - epFile + f;
+            if (board[from] == (Piece::Pawn | color))
+                candidates.push_back(Move(from, enPassantTarget, Piece::Pawn | enemy, false, true, Piece::None, false));
+        }
+    }
+
+    for (const Move& move : candidates) {
+        if (!leavesKingInCheck<Us>(move))
+            moves.push_back(move);
+    }
+    return moves;
+}
+
+template std::vector<Move> Board::generateEvasions<Piece::White>(int, const int*, int);
+template std::vector<Move> Board::generateEvasions<Piece::Black>(int, const int*, int);
@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "../headers/chess_engine.h"
+#include "../headers/board.h"
+#include "../headers/eval.h"
+#include "../headers/search.h"
+#include "../headers/mate_search.h"
+#include "../headers/transposition.h"
+#include "../headers/utils.h"
+
+struct ChessEngine {
+    explicit ChessEngine(int hashMB) : table(hashMB), active(nullptr), activeMate(nullptr) {}
+
+    Board board;
+    // Positions are built here first so that a bad FEN or move leaves board alone.
+    Board scratch;
+    TranspositionTable table;
+    std::mutex lock;
+    Search* active;
+    MateSearch* activeMate;
+};
+
+namespace {
+
+void toChessMove(const Move& move, ChessMove& out) {
+    out.from = move.from;
+    out.to = move.to;
+    writeMoveUCI(move, out.uci);
+    out.promotion = out.uci[4];
+}
+
+// Both kings present and the side that just moved not left in check.
+bool isPlayable(const Board& board) {
+    int them = (board.sideToMove == Piece::White) ? Piece::Black : Piece::White;
+    return board.findKing(Piece::White) != -1 && board.findKing(Piece::Black) != -1 &&
+           !board.isKingInCheck(them);
+}
+
+// Plays text's move if it is legal in board.
+bool playMove(Board& board, const char* text, int length) {
+    Move move;
+    if (!parseLegalUCIMove(board, text, length, move))
+        return false;
+    board.makeMove(move);
+    return true;
+}
+
+}
+
+int chess_engine_api_version(void) {
+    return CHESS_ENGINE_API_VERSION;
+}
+
+ChessEngine* chess_engine_new(int hash_mb) {
+    ChessEngine* engine = new ChessEngine(hash_mb > 0 ? hash_mb : 16);
+    engine->board.fenPosition(START_FEN);
+    return engine;
+}
+
+void chess_engine_free(ChessEngine* engine) {
+    delete engine;
+}
+
+void chess_engine_new_game(ChessEngine* engine) {
+    engine->table.clear();
+    engine->board.fenPosition(START_FEN);
+}
+
+int chess_engine_set_position(ChessEngine* engine, const char* fen, const char* moves) {
+    Board& board = engine->scratch;
+    if (!board.fenPosition(fen ? fen : START_FEN) || !isPlayable(board))
+        return CHESS_ERROR_INVALID_FEN;
+
+    if (moves) {
+        const char* p = moves;
+        for (;;) {
+            while (*p == ' ')
+                p++;
+            if (*p == '\0')
+                break;
+            const char* begin = p;
+            while (*p != ' ' && *p != '\0')
+                p++;
+            if (!playMove(board, begin, static_cast<int>(p - begin)))
+                return CHESS_ERROR_ILLEGAL_MOVE;
+        }
+    }
+    engine->board = board;
+    return CHESS_OK;
+}
+
+int chess_engine_make_move(ChessEngine* engine, const char* uci) {
+    if (!uci)
+        return CHESS_ERROR_ARGUMENT;
+    return playMove(engine->board, uci, static_cast<int>(std::strlen(uci))) ? CHESS_OK : CHESS_ERROR_ILLEGAL_MOVE;
+}
+
+int chess_engine_legal_moves(ChessEngine* engine, ChessMove* moves) {
+    std::vector<Move> legal = engine->board.generateLegalMoves();
+    int count = std::min(static_cast<int>(legal.size()), CHESS_MAX_MOVES);
+    for (int i = 0; i < count; i++)
+        toChessMove(legal[i], moves[i]);
+    return count;
+}
+
+int chess_engine_in_check(ChessEngine* engine) {
+    return engine->board.inCheck() ? 1 : 0;
+}
+
+int chess_engine_evaluate(ChessEngine* engine) {
+    return Evaluator::evaluate(engine->board);
+}
+
+int chess_engine_search(ChessEngine* engine, const ChessSearchLimits* limits,
+                        ChessProgressCallback progress, void* user_data,
+                        ChessSearchResult* result) {
+    if (!result)
+        return CHESS_ERROR_ARGUMENT;
+    if (engine->board.generateLegalMoves().empty())
+        return CHESS_ERROR_NO_LEGAL_MOVES;
+
+    SearchLimits searchLimits;
+    if (limits) {
+        if (limits->depth > 0)
+            searchLimits.depth = limits->depth;
+        searchLimits.nodes = limits->nodes;
+        searchLimits.moveTime = limits->move_time_ms;
+        searchLimits.whiteTime = limits->white_time_ms;
+        searchLimits.blackTime = limits->black_time_ms;
+        searchLimits.whiteIncrement = limits->white_increment_ms;
+        searchLimits.blackIncrement = limits->black_increment_ms;
+        searchLimits.movesToGo = limits->moves_to_go;
+        searchLimits.multiPV = std::max(1, limits->multipv);
+    }
+
+    // Search holds its principal variation tables inline; keep them off
+    // the caller's stack.
+    std::unique_ptr<Search> search(new Search(engine->board, searchLimits, &engine->table));
+    search->setOutput([](const std::string&) {});
+    if (progress) {
+        search->setProgress([progress, user_data](const SearchProgress& line) {
+            ChessMove pv[CHESS_MAX_PV];
+            int length = std::min(line.pvLength, CHESS_MAX_PV);
+            for (int i = 0; i < length; i++)
+                toChessMove(line.pv[i], pv[i]);
+            ChessSearchInfo info = {line.depth, line.multiPV, line.score, line.nodes, line.timeMs, length, pv};
+            progress(&info, user_data);
+        });
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(engine->lock);
+        engine->active = search.get();
+    }
+    Move bestMove = search->findBestMove();
+    {
+        std::lock_guard<std::mutex> guard(engine->lock);
+        engine->active = nullptr;
+    }
+
+    toChessMove(bestMove, result->best_move);
+    toChessMove(search->getPonderMove(), result->ponder_move);
+    result->score = search->getScore();
+    return CHESS_OK;
+}
+
+int chess_engine_find_mate(ChessEngine* engine, int moves, const ChessSearchLimits* limits,
+                           int table_mb, ChessMateResult* result) {
+    if (!result || moves < 1)
+        return CHESS_ERROR_ARGUMENT;
+
+    SearchLimits searchLimits;
+    if (limits) {
+        searchLimits.nodes = limits->nodes;
+        searchLimits.moveTime = limits->move_time_ms;
+        searchLimits.whiteTime = limits->white_time_ms;
+        searchLimits.blackTime = limits->black_time_ms;
+        searchLimits.whiteIncrement = limits->white_increment_ms;
+        searchLimits.blackIncrement = limits->black_increment_ms;
+        searchLimits.movesToGo = limits->moves_to_go;
+    }
+    std::unique_ptr<MateSearch> search(new MateSearch(engine->board, moves, searchLimits, table_mb > 0 ? table_mb : 64));
+    search->setOutput([](const std::string&) {});
+
+    {
+        std::lock_guard<std::mutex> guard(engine->lock);
+        engine->activeMate = search.get();
+    }
+    MateStatus status = search->solve();
+    {
+        std::lock_guard<std::mutex> guard(engine->lock);
+        engine->activeMate = nullptr;
+    }
+
+    result->status = status == MATE_FOUND ? CHESS_MATE_FOUND
+                   : status == MATE_NONE ? CHESS_MATE_NONE : CHESS_MATE_UNKNOWN;
+    result->mate_in = search->getMateMoves();
+    const std::vector<Move>& line = search->getLine();
+    result->line_length = std::min(static_cast<int>(line.size()), CHESS_MAX_PV);
+    for (int i = 0; i < result->line_length; i++)
+        toChessMove(line[i], result->line[i]);
+    result->nodes = search->getNodes();
+    return CHESS_OK;
+}
+
+void chess_engine_stop(ChessEngine* engine) {
+    std::lock_guard<std::mutex> guard(engine->lock);
+    if (engine->active)
+        engine->active->stop();
+    if (engine->activeMate)
+        engine->activeMate->stop();
+}
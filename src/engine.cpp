@@ -1,83 +1,41 @@
+#include <algorithm>
 #include <iostream>
 #include <string>
-#include <sstream>
-#include <random>
-#include "../headers/board.h"
-#include "../headers/utils.h"
-#include "../headers/search.h"
+#include <thread>
+#include <cstdlib>
+#include "../headers/uci_session.h"
+#include "../headers/server.h"
 
-int main() {
-    Board board;
-    std::string startFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
-    board.fenPosition(startFEN);
+// chessEngine             speaks UCI on standard input and output.
+// chessEngine --server P  hosts many sessions on the Unix socket P; see
+//                         headers/server.h. --threads N sets the search
+//                         threads and --hash MB the shared table size.
+int main(int argc, char** argv) {
+    std::string socketPath;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    int hashMB = 256;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--server")
+            socketPath = argv[i + 1];
+        else if (arg == "--threads")
+            threads = std::max(1, std::atoi(argv[i + 1]));
+        else if (arg == "--hash")
+            hashMB = std::max(1, std::atoi(argv[i + 1]));
+    }
+    if (!socketPath.empty())
+        return runServer(socketPath, threads, hashMB);
 
+    // The search runs on its own thread so that stop and ponderhit can be
+    // handled while it thinks.
+    WorkerPool pool(1);
+    UciSession session([](const std::string& text) { std::cout << text << std::flush; }, pool);
     std::string line;
     while (std::getline(std::cin, line)) {
-        if (line.empty()) continue;
-        std::istringstream iss(line);
-        std::string token;
-        iss >> token;
-
-        if (token == "uci") {
-            std::cout << "id name chessEngine\n";
-            std::cout << "id author Rounak Paul\n";
-            std::cout << "uciok\n";
-        } else if (token == "perft") {
-            int depth;
-            iss >> depth;
-            for(int i = 1; i <= depth; i++)
-                std::cout << "depth " << i << ": " << board.moveGenerationTest(i) << std::endl;
-        } else if (token == "isready") {
-            std::cout << "readyok\n";
-        } else if (token == "position") {
-            std::string posType;
-            iss >> posType;
-            if (posType == "startpos") {
-                board.fenPosition(startFEN);
-                std::string movesToken;
-                if (iss >> movesToken && movesToken == "moves") {
-                    std::string moveStr;
-                    while (iss >> moveStr) {
-                        std::vector<Move> legalMoves = board.generateLegalMoves();
-                        for (const Move& m : legalMoves) {
-                            if (moveToUCI(m) == moveStr) {
-                                board.makeMove(m);
-                                break;
-                            }
-                        }
-                    }
-                }
-            } else if (posType == "fen") {
-                std::string fen, tokenPart;
-                while (iss >> tokenPart && tokenPart != "moves") {
-                    fen += tokenPart + " ";
-                }
-                board.fenPosition(fen);
-                if (tokenPart == "moves") {
-                    std::string moveStr;
-                    while (iss >> moveStr) {
-                        std::vector<Move> legalMoves = board.generateLegalMoves();
-                        for (const Move& m : legalMoves) {
-                            if (moveToUCI(m) == moveStr) {
-                                board.makeMove(m);
-                                break;
-                            }
-                        }
-                    }
-                }
-            }
-        } else if (token == "go") {
-            std::vector<Move> legalMoves = board.generateLegalMoves();
-            Search search(board, 4);
-            Move bestMove = search.findBestMove();
-
-            std::cout << "bestmove " << moveToUCI(bestMove) << std::endl;
-
-            int evaluation = Evaluator::evaluate(board);
-            std::cout << "Evaluation: " << evaluation << std::endl;
-        } else if (token == "quit") {
-            break;
-        }
+        if (!session.handleCommand(line))
+            return 0;
     }
+    // End of input: let a bounded search finish and report its move.
+    session.endOfInput();
     return 0;
-}
\ No newline at end of file
+}
@@ -1,76 +1,63 @@
 #include "../headers/eval.h"
-#include <cmath>
+#include "../headers/eval_tables.h"
 #include <algorithm>
 
-int Evaluator::piecePositionalValue(const Piece& piece, int square) {
-    int file = square % 8;
-    int rank = square / 8;
+namespace {
+
+EvalParams loadDefaults() {
+    EvalParams params;
+    std::copy(EVAL_PIECE_VALUES, EVAL_PIECE_VALUES + 7, params.pieceValue);
+    for (int type = 0; type < 7; type++)
+        std::copy(EVAL_PIECE_SQUARE[type], EVAL_PIECE_SQUARE[type] + 64, params.pieceSquare[type]);
+    params.centerPawnBonus = EVAL_CENTER_PAWN_BONUS;
+    return params;
+}
 
-    double dist = std::abs(file - 3.5) + std::abs(rank - 3.5);
-    int bonus = static_cast<int>(7 - dist);
+const EvalParams defaults = loadDefaults();
 
-    switch(piece.getType()) {
-        case Piece::Knight:
-            bonus = bonus * 2 + 3;
-            break;
-        case Piece::Bishop:
-            bonus = bonus * 2 + 5;
-            break;
-        case Piece::Pawn:
-            bonus = bonus / 2;
-            break;
-        case Piece::King:
-            bonus = 0;
-            break;
-        default:
-            break;
-    }
-    return bonus;
+}
+
+const EvalParams& Evaluator::defaultParams() {
+    return defaults;
+}
+
+int Evaluator::piecePositionalValue(const Piece& piece, int square) {
+    int relative = isWhite(piece) ? square : square ^ 56;
+    return defaults.pieceSquare[piece.getType()][relative];
 }
 
 int Evaluator::evaluate(const Board& board) {
+    return evaluate(board, defaults);
+}
+
+int Evaluator::evaluate(const Board& board, const EvalParams& params) {
     int score = 0;
+    bool opening = board.moveCount < OPENING_PLIES;
 
     for (int i = 0; i < 64; ++i) {
-        Piece piece = board.getPieceAt(i);
-        if (piece.getType() != Piece::None) {
-            int material   = pieceValue(piece);
-            int positional = piecePositionalValue(piece, i);
-            int pieceScore = material + positional;
-            if (isWhite(piece))
-                score += pieceScore;
-            else
-                score -= pieceScore;
-        }
-    }
-    
-    if (board.moveCount < 20) {
-        for (int i = 0; i < 64; ++i) {
-            Piece piece = board.getPieceAt(i);
-            if (piece.getType() == Piece::Pawn) {
-                int file = i % 8;
-                int rank = i / 8;
-                if (piece.getColor() == Piece::White && rank < 6 && (file == 3 || file == 4))
-                    score += 20;
-                if (piece.getColor() == Piece::Black && rank > 1 && (file == 3 || file == 4))
-                    score -= 20;
-            }
-        }
+        int code = board.board[i];
+        if (code == Piece::None)
+            continue;
+        int type = code & 7;
+        bool white = (code & Piece::White) != 0;
+        // Square as seen from the piece's own side.
+        int relative = white ? i : i ^ 56;
+        int pieceScore = params.pieceValue[type] + params.pieceSquare[type][relative];
+        // Centre pawns that have left their start square.
+        if (opening && type == Piece::Pawn && relative / 8 < 6 &&
+            (relative % 8 == 3 || relative % 8 == 4))
+            pieceScore += params.centerPawnBonus;
+        if (white)
+            score += pieceScore;
+        else
+            score -= pieceScore;
     }
-    
+
     return score;
 }
 
 int Evaluator::pieceValue(const Piece& piece) {
-    switch (piece.getType()) {
-        case Piece::King:   return KING_VALUE;
-        case Piece::Queen:  return QUEEN_VALUE;
-        case Piece::Rook:   return ROOK_VALUE;
-        case Piece::Bishop: return BISHOP_VALUE;
-        case Piece::Knight: return KNIGHT_VALUE;
-        case Piece::Pawn:   return PAWN_VALUE;
-        default: return 0;
-    }
+    return defaults.pieceValue[piece.getType()];
 }
 
 bool Evaluator::isWhite(const Piece& piece) {
@@ -79,4 +66,4 @@ bool Evaluator::isWhite(const Piece& piece) {
 
 bool Evaluator::isBlack(const Piece& piece) {
     return piece.getColor() == Piece::Black;
-}
\ No newline at end of file
+}
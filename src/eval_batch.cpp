@@ -0,0 +1,138 @@
+#include "../headers/eval_batch.h"
+#include <algorithm>
+#include <memory>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define EVAL_BATCH_X86
+#endif
+
+namespace {
+
+const int OPENING_PHASE = 32;
+
+// The table is 16 KB; keep it off the stack.
+std::unique_ptr<EvalBatch::Table> makeTable(const EvalParams& params) {
+    std::unique_ptr<EvalBatch::Table> table(new EvalBatch::Table());
+    EvalBatch::buildTable(params, *table);
+    return table;
+}
+
+const EvalBatch::Table& defaultTable() {
+    static const std::unique_ptr<EvalBatch::Table> table = makeTable(Evaluator::defaultParams());
+    return *table;
+}
+
+}
+
+EvalBatch::EvalBatch(int capacity)
+    : maxCount(std::max(1, capacity)), count(0) {
+    // Whole blocks, so the last block's spare lanes can be read too.
+    int blocks = (maxCount + BLOCK - 1) / BLOCK;
+    pieces.assign(blocks * 64 * BLOCK, Piece::None);
+    phase.assign(blocks * BLOCK, 0);
+}
+
+int EvalBatch::add(const Board& board) {
+    if (count == maxCount)
+        return -1;
+    uint8_t* column = &pieces[count / BLOCK * 64 * BLOCK + count % BLOCK];
+    for (int square = 0; square < 64; square++)
+        column[square * BLOCK] = board.board[square];
+    phase[count] = board.moveCount < Evaluator::OPENING_PLIES ? OPENING_PHASE : 0;
+    return count++;
+}
+
+// Mirrors Evaluator::evaluate term by term.
+void EvalBatch::buildTable(const EvalParams& params, Table& table) {
+    for (int square = 0; square < 64; square++) {
+        for (int index = 0; index < 64; index++) {
+            int code = index & 31;
+            bool opening = (index & OPENING_PHASE) != 0;
+            int type = code & 7;
+            int color = code & (Piece::White | Piece::Black);
+            if (type == Piece::None || type > Piece::Queen ||
+                (color != Piece::White && color != Piece::Black)) {
+                table.values[square][index] = 0;
+                continue;
+            }
+            bool white = color == Piece::White;
+            int relative = white ? square : square ^ 56;
+            int value = params.pieceValue[type] + params.pieceSquare[type][relative];
+            if (opening && type == Piece::Pawn && relative / 8 < 6 &&
+                (relative % 8 == 3 || relative % 8 == 4))
+                value += params.centerPawnBonus;
+            table.values[square][index] = white ? value : -value;
+        }
+    }
+}
+
+bool EvalBatch::hasAVX2() {
+#ifdef EVAL_BATCH_X86
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+void EvalBatch::evaluate(int* scores) const {
+    const Table& table = defaultTable();
+    if (hasAVX2())
+        evaluateAVX2(table, scores);
+    else
+        evaluateScalar(table, scores);
+}
+
+void EvalBatch::evaluate(const EvalParams& params, int* scores) const {
+    std::unique_ptr<Table> table = makeTable(params);
+    if (hasAVX2())
+        evaluateAVX2(*table, scores);
+    else
+        evaluateScalar(*table, scores);
+}
+
+void EvalBatch::evaluateScalar(const EvalParams& params, int* scores) const {
+    evaluateScalar(*makeTable(params), scores);
+}
+
+void EvalBatch::evaluateScalar(const Table& table, int* scores) const {
+    for (int i = 0; i < count; i++) {
+        const uint8_t* column = &pieces[i / BLOCK * 64 * BLOCK + i % BLOCK];
+        int score = 0;
+        for (int square = 0; square < 64; square++)
+            score += table.values[square][column[square * BLOCK] | phase[i]];
+        scores[i] = score;
+    }
+}
+
+#ifdef EVAL_BATCH_X86
+// Eight positions per step: widen their codes on one square to 32 bits,
+// add the phase and gather the values from that square's table row. Lanes
+// past the last position read leftover codes, which still index inside the
+// row, and are not stored.
+__attribute__((target("avx2")))
+void EvalBatch::evaluateAVX2(const Table& table, int* scores) const {
+    for (int i = 0; i < count; i += BLOCK) {
+        const uint8_t* block = &pieces[i * 64];
+        __m128i phase8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&phase[i]));
+        __m256i phases = _mm256_cvtepu8_epi32(phase8);
+        __m256i sum = _mm256_setzero_si256();
+        for (int square = 0; square < 64; square++) {
+            __m128i codes8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(block + square * BLOCK));
+            __m256i index = _mm256_or_si256(_mm256_cvtepu8_epi32(codes8), phases);
+            sum = _mm256_add_epi32(sum, _mm256_i32gather_epi32(table.values[square], index, 4));
+        }
+        if (count - i >= BLOCK) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(scores + i), sum);
+        } else {
+            alignas(32) int lanes[BLOCK];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sum);
+            std::copy(lanes, lanes + (count - i), scores + i);
+        }
+    }
+}
+#else
+void EvalBatch::evaluateAVX2(const Table& table, int* scores) const {
+    evaluateScalar(table, scores);
+}
+#endif
@@ -1,42 +1,113 @@
 #include "../headers/board.h"
+#include <algorithm>
+#include <cctype>
 
-void Board::fenPosition(const std::string& fen) {
-    std::unordered_map<char, int> pieceTable = {
-        {'k', Piece::King}, {'q', Piece::Queen}, {'p', Piece::Pawn},
-        {'b', Piece::Bishop}, {'n', Piece::Knight}, {'r', Piece::Rook}
-    };
+namespace {
 
-    fill(board.begin(), board.end(), Piece::None);
-    std::stringstream ss(fen);
-    std::string boardPart, turn, castling, enPassant;
-    int halfmoveClock, fullmoveNumber;
-    ss >> boardPart >> turn >> castling >> enPassant >> halfmoveClock >> fullmoveNumber;
+int pieceFromChar(char c) {
+    switch (tolower(c)) {
+        case 'k': return Piece::King;
+        case 'q': return Piece::Queen;
+        case 'p': return Piece::Pawn;
+        case 'b': return Piece::Bishop;
+        case 'n': return Piece::Knight;
+        case 'r': return Piece::Rook;
+        default:  return Piece::None;
+    }
+}
+
+// Advances over the next space-separated field of the FEN, returning its
+// bounds as [begin, end) without copying it out of the text.
+bool nextField(const char* fen, size_t length, size_t& pos, size_t& begin, size_t& end) {
+    while (pos < length && isspace(static_cast<unsigned char>(fen[pos])))
+        pos++;
+    begin = pos;
+    while (pos < length && !isspace(static_cast<unsigned char>(fen[pos])))
+        pos++;
+    end = pos;
+    return begin != end;
+}
+
+int parseNumber(const char* fen, size_t begin, size_t end, int fallback) {
+    if (begin == end)
+        return fallback;
+    int value = 0;
+    for (size_t i = begin; i < end; i++) {
+        if (!isdigit(static_cast<unsigned char>(fen[i])))
+            return fallback;
+        value = value * 10 + (fen[i] - '0');
+    }
+    return value;
+}
+
+}
+
+bool Board::fenPosition(const char* fen, size_t length) {
+    std::fill(board, board + 64, Piece::None);
 
+    size_t pos = 0, begin = 0, end = 0;
+
+    // Piece placement.
+    nextField(fen, length, pos, begin, end);
     int rank = 0, file = 0;
-    for (char c : boardPart) {
+    for (size_t i = begin; i < end; i++) {
+        char c = fen[i];
         if (c == '/') {
             rank++;
             file = 0;
-        } else if (isdigit(c)) {
+        } else if (isdigit(static_cast<unsigned char>(c))) {
             file += c - '0';
         } else {
-            int color = isupper(c) ? Piece::White : Piece::Black;
-            int piece = pieceTable[tolower(c)];
-            board[rank * 8 + file] = piece | color;
+            int color = isupper(static_cast<unsigned char>(c)) ? Piece::White : Piece::Black;
+            int piece = pieceFromChar(c);
+            if (piece != Piece::None && rank < 8 && file < 8)
+                board[rank * 8 + file] = piece | color;
             file++;
         }
     }
 
-    sideToMove = (turn == "w") ? Piece::White : Piece::Black;
-    canCastleKingsideWhite = (castling.find('K') != std::string::npos);
-    canCastleQueensideWhite = (castling.find('Q') != std::string::npos);
-    canCastleKingsideBlack = (castling.find('k') != std::string::npos);
-    canCastleQueensideBlack = (castling.find('q') != std::string::npos);
+    // Side to move.
+    nextField(fen, length, pos, begin, end);
+    sideToMove = (begin != end && fen[begin] == 'b') ? Piece::Black : Piece::White;
+
+    // Castling rights.
+    castlingRights = 0;
+    nextField(fen, length, pos, begin, end);
+    for (size_t i = begin; i < end; i++) {
+        switch (fen[i]) {
+            case 'K': castlingRights |= CastleWhiteKingside; break;
+            case 'Q': castlingRights |= CastleWhiteQueenside; break;
+            case 'k': castlingRights |= CastleBlackKingside; break;
+            case 'q': castlingRights |= CastleBlackQueenside; break;
+            default: break;
+        }
+    }
 
+    // En passant target square: behind a pawn that just moved two squares,
+    // so on the sixth rank with White to move and the third with Black.
+    // Anything else is dropped and the FEN reported as invalid.
+    bool valid = true;
     enPassantTarget = -1;
-    if (enPassant != "-") {
-        int fileEp = enPassant[0] - 'a';
-        int rankEp = 8 - (enPassant[1] - '0');
-        enPassantTarget = rankEp * 8 + fileEp;
+    nextField(fen, length, pos, begin, end);
+    if (end - begin == 2 && fen[begin] != '-') {
+        char targetRank = (sideToMove == Piece::White) ? '6' : '3';
+        if (fen[begin] >= 'a' && fen[begin] <= 'h' && fen[begin + 1] == targetRank)
+            enPassantTarget = (8 - (targetRank - '0')) * 8 + (fen[begin] - 'a');
+        else
+            valid = false;
+    } else if (end != begin && !(end - begin == 1 && fen[begin] == '-')) {
+        valid = false;
     }
+
+    // Halfmove clock and fullmove number are optional.
+    nextField(fen, length, pos, begin, end);
+    halfmoveClock = parseNumber(fen, begin, end, 0);
+    nextField(fen, length, pos, begin, end);
+    int fullmoveNumber = parseNumber(fen, begin, end, 1);
+    moveCount = 2 * (std::max(fullmoveNumber, 1) - 1) + (sideToMove == Piece::Black ? 1 : 0);
+
+    historyCount = 0;
+    zobristKey = computeZobristKey();
+    attacksValid = false;
+    return valid;
 }
@@ -1,88 +1,218 @@
 #include "../headers/board.h"
+#include "../headers/color_traits.h"
+#include "../headers/attack_tables.h"
 
-// Generate legal moves by filtering out pseudo–moves that leave the king in check.
 std::vector<Move> Board::generateLegalMoves() {
+    return (sideToMove == Piece::White) ? generateLegalMoves<Piece::White>()
+                                        : generateLegalMoves<Piece::Black>();
+}
+
+// Generate legal moves by filtering out pseudo–moves that leave the king in
+// check. The position's attack record settles most moves without playing
+// them: out of check, only king moves, pinned pieces and en passant captures
+// can expose the king.
+template<int Us>
+std::vector<Move> Board::generateLegalMoves() {
+    const AttackInfo& info = attackInfo();
+    int kingSquare = info.kingSquare[sideIndex(Us)];
+    // In check only a few moves can be legal; generate just those.
+    if (info.checkers) {
+        int checkers[32];
+        int checkerCount = 0;
+        for (uint64_t bits = info.checkers; bits; bits &= bits - 1)
+            checkers[checkerCount++] = __builtin_ctzll(bits);
+        return generateEvasions<Us>(kingSquare, checkers, checkerCount);
+    }
+    const uint64_t enemyAttacks = info.enemyAttacks;
+
     std::vector<Move> legalMoves;
-    std::vector<Move> pseudoMoves;
 
     for (int i = 0; i < 64; i++) {
         // Only consider pieces of the side to move.
-        if (board[i] == Piece::None || ((board[i] & (Piece::White | Piece::Black)) != sideToMove))
+        if (!(board[i] & Us))
             continue;
-        int pieceType = board[i] & 7;
-        switch (pieceType) {
-            case Piece::Pawn:
-                pseudoMoves = generatePawnMoves(i, sideToMove);
-                break;
-            case Piece::Knight:
-                pseudoMoves = generateKnightMoves(i, sideToMove);
-                break;
-            case Piece::Bishop:
-                pseudoMoves = generateBishopMoves(i, sideToMove);
-                break;
-            case Piece::Rook:
-                pseudoMoves = generateRookMoves(i, sideToMove);
-                break;
-            case Piece::Queen:
-                pseudoMoves = generateQueenMoves(i, sideToMove);
-                break;
-            case Piece::King: {
-                bool canK = (sideToMove == Piece::White) ? canCastleKingsideWhite : canCastleKingsideBlack;
-                bool canQ = (sideToMove == Piece::White) ? canCastleQueensideWhite : canCastleQueensideBlack;
-                pseudoMoves = generateKingMoves(i, sideToMove, canK, canQ);
-                break;
-            }
-            default:
-                pseudoMoves.clear();
-                break;
+        std::vector<Move> pseudoMoves = generatePieceMoves<Us>(i);
+        bool pinned = (info.pinned & squareBit(i)) != 0;
+        for (const Move& move : pseudoMoves) {
+            bool legal;
+            if (i == kingSquare)
+                // Castling moves were only generated over safe squares.
+                legal = move.isCastling || !(enemyAttacks & squareBit(move.to));
+            else if (pinned || move.isEnPassant)
+                legal = !leavesKingInCheck<Us>(move);
+            else
+                legal = true;
+            if (legal)
+                legalMoves.push_back(move);
         }
-        // For each pseudo–move, simulate it and check that the king isn’t left in check.
-        for (Move move : pseudoMoves) {
-            int fromPiece = board[move.from];
-            int toPiece = board[move.to];
-            int oldEnPassant = enPassantTarget;
-            bool isEp = move.isEnPassant;
-            int epPawnSquare = -1;
-            bool isCastle = move.isCastling;
-            int rookFrom = -1, rookTo = -1;
-            int rookPiece = Piece::None; // for castling simulation
-
-            // Make the move.
-            board[move.from] = Piece::None;
-            board[move.to] = fromPiece;
-            if (isEp) {
-                epPawnSquare = move.to + ((sideToMove == Piece::White) ? 8 : -8);
-                board[epPawnSquare] = Piece::None;
+    }
+    return legalMoves;
+}
+
+// Pseudo-legal moves of the side-to-move piece on square.
+template<int Us>
+std::vector<Move> Board::generatePieceMoves(int square) {
+    switch (board[square] & 7) {
+        case Piece::Pawn:   return generatePawnMoves<Us>(square);
+        case Piece::Knight: return generateKnightMoves<Us>(square);
+        case Piece::Bishop: return generateBishopMoves<Us>(square);
+        case Piece::Rook:   return generateRookMoves<Us>(square);
+        case Piece::Queen:  return generateQueenMoves<Us>(square);
+        case Piece::King:   return generateKingMoves<Us>(square);
+        default:            return std::vector<Move>();
+    }
+}
+
+bool Board::isLegal(const Move& move) {
+    return (sideToMove == Piece::White) ? isLegal<Piece::White>(move)
+                                        : isLegal<Piece::Black>(move);
+}
+
+// One move checked without generating the whole legal list: it must be among
+// the moving piece's own moves, and must not leave the king attacked.
+template<int Us>
+bool Board::isLegal(const Move& move) {
+    if (move.from < 0 || move.from >= 64 || !(board[move.from] & Us))
+        return false;
+    for (const Move& candidate : generatePieceMoves<Us>(move.from)) {
+        if (candidate.to == move.to && candidate.isPromotion == move.isPromotion &&
+            (!candidate.isPromotion || candidate.promotionPiece == move.promotionPiece))
+            // Castling moves were only generated over safe squares.
+            return candidate.isCastling || !leavesKingInCheck<Us>(candidate);
+    }
+    return false;
+}
+
+// Legal captures only, en passant and capturing promotions included, for
+// the quiescence search: each piece looks just at the squares it could
+// capture on, so no quiet move is generated and thrown away. Not for a side
+// in check; generateLegalMoves gives the evasions then.
+template<int Us>
+std::vector<Move> Board::generateLegalCaptures() {
+    typedef ColorTraits<Us> Traits;
+    const AttackInfo& info = attackInfo();
+    int kingSquare = info.kingSquare[sideIndex(Us)];
+    const uint64_t enemyAttacks = info.enemyAttacks;
+
+    std::vector<Move> candidates;
+    for (int from = 0; from < 64; from++) {
+        if (!(board[from] & Us))
+            continue;
+        int type = board[from] & 7;
+        int rank = from / 8, file = from % 8;
+
+        if (type == Piece::Pawn) {
+            int r = rank + Traits::Forward / 8;
+            bool promotes = (r == Traits::PromotionRank);
+            for (int df = -1; df <= 1; df += 2) {
+                int f = file + df;
+                if (r < 0 || r >= 8 || f < 0 || f >= 8)
+                    continue;
+                int target = r * 8 + f;
+                if (board[target] & Traits::Them) {
+                    if (promotes) {
+                        for (int promo : {Piece::Queen, Piece::Rook, Piece::Bishop, Piece::Knight})
+                            candidates.push_back(Move(from, target, board[target], true, false, promo, false));
+                    } else {
+                        candidates.push_back(Move(from, target, board[target], false, false, Piece::None, false));
+                    }
+                } else if (target == enPassantTarget &&
+                           board[target - Traits::Forward] == (Piece::Pawn | Traits::Them)) {
+                    candidates.push_back(Move(from, target, Piece::Pawn | Traits::Them, false, true, Piece::None, false));
+                }
             }
-            if (isCastle) {
-                if (move.to == move.from + 2) { // kingside
-                    rookFrom = move.from + 3;
-                    rookTo = move.from + 1;
-                } else { // queenside
-                    rookFrom = move.from - 4;
-                    rookTo = move.from - 1;
+        } else if (type == Piece::Knight || type == Piece::King) {
+            uint64_t targets = (type == Piece::Knight) ? stepAttacks.knight[from] : stepAttacks.king[from];
+            for (; targets; targets &= targets - 1) {
+                int target = __builtin_ctzll(targets);
+                if (board[target] & Traits::Them)
+                    candidates.push_back(Move(from, target, board[target], false, false, Piece::None, false));
+            }
+        } else {
+            int first = (type == Piece::Bishop) ? 4 : 0;
+            int last = (type == Piece::Rook) ? 4 : 8;
+            for (int dir = first; dir < last; dir++) {
+                int dr = lineSteps[dir][0], df = lineSteps[dir][1];
+                for (int r = rank + dr, f = file + df; r >= 0 && r < 8 && f >= 0 && f < 8; r += dr, f += df) {
+                    int target = r * 8 + f;
+                    if (board[target] == Piece::None)
+                        continue;
+                    if (board[target] & Traits::Them)
+                        candidates.push_back(Move(from, target, board[target], false, false, Piece::None, false));
+                    break;
                 }
-                rookPiece = board[rookFrom];
-                board[rookFrom] = Piece::None;
-                board[rookTo] = rookPiece;
             }
+        }
+    }
 
-            bool inCheck = isKingInCheck(sideToMove);
+    // The same legality rules as generateLegalMoves outside check.
+    std::vector<Move> captures;
+    for (const Move& move : candidates) {
+        bool legal;
+        if (move.from == kingSquare)
+            legal = !(enemyAttacks & squareBit(move.to));
+        else if ((info.pinned & squareBit(move.from)) || move.isEnPassant)
+            legal = !leavesKingInCheck<Us>(move);
+        else
+            legal = true;
+        if (legal)
+            captures.push_back(move);
+    }
+    return captures;
+}
 
-            // Undo the move.
-            board[move.from] = fromPiece;
-            board[move.to] = toPiece;
-            if (isEp)
-                board[epPawnSquare] = move.capturePiece;
-            if (isCastle) {
-                board[rookFrom] = rookPiece;
-                board[rookTo] = Piece::None;
-            }
-            enPassantTarget = oldEnPassant;
+// Plays the move on the squares only, tests the mover's king, and puts
+// everything back.
+template<int Us>
+bool Board::leavesKingInCheck(const Move& move) {
+    int fromPiece = board[move.from];
+    int toPiece = board[move.to];
+    bool isEp = move.isEnPassant;
+    int epPawnSquare = -1;
+    bool isCastle = move.isCastling;
+    int rookFrom = -1, rookTo = -1;
+    int rookPiece = Piece::None; // for castling simulation
 
-            if (!inCheck)
-                legalMoves.push_back(move);
+    // Make the move.
+    board[move.from] = Piece::None;
+    board[move.to] = fromPiece;
+    if (isEp) {
+        epPawnSquare = move.to - ColorTraits<Us>::Forward;
+        board[epPawnSquare] = Piece::None;
+    }
+    if (isCastle) {
+        if (move.to == move.from + 2) { // kingside
+            rookFrom = move.from + 3;
+            rookTo = move.from + 1;
+        } else { // queenside
+            rookFrom = move.from - 4;
+            rookTo = move.from - 1;
         }
+        rookPiece = board[rookFrom];
+        board[rookFrom] = Piece::None;
+        board[rookTo] = rookPiece;
     }
-    return legalMoves;
-}
\ No newline at end of file
+
+    bool inCheck = isKingInCheck<Us>();
+
+    // Undo the move.
+    board[move.from] = fromPiece;
+    board[move.to] = toPiece;
+    if (isEp)
+        board[epPawnSquare] = move.capturePiece;
+    if (isCastle) {
+        board[rookFrom] = rookPiece;
+        board[rookTo] = Piece::None;
+    }
+
+    return inCheck;
+}
+
+template std::vector<Move> Board::generateLegalMoves<Piece::White>();
+template std::vector<Move> Board::generateLegalMoves<Piece::Black>();
+template std::vector<Move> Board::generateLegalCaptures<Piece::White>();
+template std::vector<Move> Board::generateLegalCaptures<Piece::Black>();
+template bool Board::leavesKingInCheck<Piece::White>(const Move&);
+template bool Board::leavesKingInCheck<Piece::Black>(const Move&);
+template bool Board::isLegal<Piece::White>(const Move&);
+template bool Board::isLegal<Piece::Black>(const Move&);
@@ -0,0 +1,326 @@
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include "../headers/mate_search.h"
+#include "../headers/utils.h"
+
+namespace {
+
+// Proof numbers saturate here; a node at INFINITE is settled.
+const uint32_t INFINITE = 1u << 30;
+
+uint32_t addSaturated(uint32_t a, uint32_t b) {
+    return std::min(INFINITE, a + b);
+}
+
+}
+
+MateTable::MateTable(int sizeMB) : mask(0) {
+    resize(sizeMB);
+}
+
+void MateTable::resize(int sizeMB) {
+    uint64_t bytes = static_cast<uint64_t>(sizeMB < 1 ? 1 : sizeMB) * 1024 * 1024;
+    uint64_t buckets = 1;
+    while (buckets * 2 * BUCKET_SIZE * sizeof(Entry) <= bytes)
+        buckets *= 2;
+    entries.assign(buckets * BUCKET_SIZE, Entry());
+    mask = buckets - 1;
+    clear();
+}
+
+void MateTable::clear() {
+    for (Entry& entry : entries) {
+        entry.key = 0;
+        entry.proof = entry.disproof = 0;
+        entry.work = 0;
+        entry.remaining = -1;
+    }
+}
+
+bool MateTable::probe(uint64_t key, int remaining, uint32_t& proof, uint32_t& disproof) const {
+    const Entry* bucket = &entries[((key ^ static_cast<uint64_t>(remaining)) & mask) * BUCKET_SIZE];
+    for (int i = 0; i < BUCKET_SIZE; i++) {
+        if (bucket[i].key == key && bucket[i].remaining == remaining) {
+            proof = bucket[i].proof;
+            disproof = bucket[i].disproof;
+            return true;
+        }
+    }
+    return false;
+}
+
+void MateTable::store(uint64_t key, int remaining, uint32_t proof, uint32_t disproof, uint64_t work) {
+    Entry* bucket = &entries[((key ^ static_cast<uint64_t>(remaining)) & mask) * BUCKET_SIZE];
+    Entry* target = &bucket[0];
+    for (int i = 0; i < BUCKET_SIZE; i++) {
+        if (bucket[i].key == key && bucket[i].remaining == remaining) {
+            target = &bucket[i];
+            break;
+        }
+        if (bucket[i].remaining < 0 || bucket[i].work < target->work)
+            target = &bucket[i];
+    }
+    target->key = key;
+    target->remaining = remaining;
+    target->proof = proof;
+    target->disproof = disproof;
+    target->work = static_cast<uint32_t>(std::min<uint64_t>(work, UINT32_MAX));
+}
+
+MateSearch::MateSearch(Board& board, int moves, const SearchLimits& limits, int tableMB)
+    : board(board), maxMoves(std::max(1, moves)), limits(limits), table(tableMB),
+      attacker(board.sideToMove), timeBudgetMs(Search::timeBudget(limits, board.sideToMove)),
+      startTimeMs(0), stopRequested(false), aborted(false), nodes(0), mateMoves(0) {}
+
+void MateSearch::stop() {
+    std::lock_guard<std::mutex> guard(waitLock);
+    stopRequested = true;
+    released.notify_all();
+}
+
+void MateSearch::emit(const std::string& text) {
+    if (output)
+        output(text);
+    else
+        std::cout << text << std::flush;
+}
+
+bool MateSearch::shouldStop() {
+    if (aborted)
+        return true;
+    if (stopRequested)
+        return aborted = true;
+    if (limits.nodes > 0 && nodes >= limits.nodes)
+        return aborted = true;
+    // A node here expands all its children, so the clock is read more often
+    // than in Search.
+    if (timeBudgetMs > 0 && (nodes & 127) == 0 &&
+        Search::clockMs() - startTimeMs >= timeBudgetMs)
+        return aborted = true;
+    return false;
+}
+
+void MateSearch::lookup(int remaining, uint32_t& proof, uint32_t& disproof) const {
+    if (!table.probe(board.zobristKey, remaining, proof, disproof)) {
+        proof = 1;
+        disproof = 1;
+    }
+}
+
+// Expands the current position until its proof or disproof number reaches
+// its threshold. At the attacker's nodes one proven move is enough, so the
+// proof number is the smallest of the children's and the disproof number
+// their sum; at the defender's nodes it is the other way round. The child
+// searched next gets thresholds that send the search back up as soon as a
+// sibling looks better. remaining counts the plies left, the attacker's
+// last move included. The numbers reached are returned as well as stored,
+// so that progress is not lost if the table drops the entry.
+void MateSearch::expand(int remaining, uint32_t proofThreshold, uint32_t disproofThreshold,
+                        uint32_t& proof, uint32_t& disproof) {
+    nodes++;
+    proof = disproof = 1;
+    if (shouldStop())
+        return;
+
+    uint64_t key = board.zobristKey;
+    long long startNodes = nodes;
+    bool attacking = board.sideToMove == attacker;
+    std::vector<Move> moves = board.generateLegalMoves();
+
+    // Settled positions: mate, stalemate, or out of plies.
+    if (moves.empty() || remaining == 0) {
+        bool mated = moves.empty() && !attacking && board.inCheck();
+        proof = mated ? 0 : INFINITE;
+        disproof = mated ? INFINITE : 0;
+        table.store(key, remaining, proof, disproof, 1);
+        return;
+    }
+
+    size_t count = moves.size();
+    std::vector<uint32_t> proofs(count), disproofs(count);
+    MoveHistory undo;
+    for (size_t i = 0; i < count; i++) {
+        board.makeMove(moves[i], undo);
+        if (remaining == 1) {
+            // The attacker's last move: settled on the spot, as only a
+            // check can mate and a check mates when there is no reply.
+            bool mate = board.inCheck() && board.generateLegalMoves().empty();
+            proofs[i] = mate ? 0 : INFINITE;
+            disproofs[i] = mate ? INFINITE : 0;
+        } else {
+            lookup(remaining - 1, proofs[i], disproofs[i]);
+        }
+        board.unmakeMove(undo);
+    }
+
+    for (;;) {
+        // Attacker nodes minimize proofs; the defender's minimize disproofs.
+        const std::vector<uint32_t>& selected = attacking ? proofs : disproofs;
+        const std::vector<uint32_t>& summed = attacking ? disproofs : proofs;
+        size_t best = 0;
+        uint32_t second = INFINITE;
+        uint32_t sum = 0;
+        for (size_t i = 0; i < count; i++) {
+            sum = addSaturated(sum, summed[i]);
+            if (selected[i] < selected[best]) {
+                second = selected[best];
+                best = i;
+            } else if (i != best && selected[i] < second) {
+                second = selected[i];
+            }
+        }
+        proof = attacking ? selected[best] : sum;
+        disproof = attacking ? sum : selected[best];
+        if (proof >= proofThreshold || disproof >= disproofThreshold)
+            break;
+
+        uint32_t childProofThreshold, childDisproofThreshold;
+        if (attacking) {
+            childProofThreshold = std::min(proofThreshold, addSaturated(second, 1));
+            childDisproofThreshold = std::min(INFINITE, disproofThreshold - disproof + disproofs[best]);
+        } else {
+            childDisproofThreshold = std::min(disproofThreshold, addSaturated(second, 1));
+            childProofThreshold = std::min(INFINITE, proofThreshold - proof + proofs[best]);
+        }
+
+        board.makeMove(moves[best], undo);
+        expand(remaining - 1, childProofThreshold, childDisproofThreshold, proofs[best], disproofs[best]);
+        board.unmakeMove(undo);
+        if (aborted)
+            return;
+    }
+    table.store(key, remaining, proof, disproof, nodes - startNodes + 1);
+}
+
+// Whether the current position is mated within remaining plies, from the
+// table or else by searching it.
+bool MateSearch::isProven(int remaining) {
+    uint32_t proof, disproof;
+    if (!table.probe(board.zobristKey, remaining, proof, disproof) || (proof != 0 && disproof != 0))
+        expand(remaining, INFINITE, INFINITE, proof, disproof);
+    return proof == 0;
+}
+
+// Plies to the quickest mate, at most maxRemaining, with the attacker to
+// move; -1 if there is none.
+int MateSearch::mateDistance(int maxRemaining) {
+    for (int remaining = 1; remaining <= maxRemaining && !aborted; remaining += 2) {
+        if (isProven(remaining))
+            return remaining;
+    }
+    return -1;
+}
+
+// Walks the proven tree from the root, mated in exactly remaining plies.
+// The attacker plays a move that keeps to that count and the defender the
+// reply that holds out longest, so the line is as long as the mate.
+void MateSearch::extractLine(int remaining) {
+    line.clear();
+    std::vector<MoveHistory> played;
+    while (!aborted && remaining > 0) {
+        std::vector<Move> moves = board.generateLegalMoves();
+        bool attacking = board.sideToMove == attacker;
+        int found = -1;
+        int foundRemaining = -1;
+        MoveHistory undo;
+        for (size_t i = 0; i < moves.size() && !aborted; i++) {
+            board.makeMove(moves[i], undo);
+            if (attacking) {
+                if (isProven(remaining - 1)) {
+                    found = static_cast<int>(i);
+                    foundRemaining = remaining - 1;
+                }
+            } else {
+                int distance = mateDistance(remaining - 1);
+                if (distance > foundRemaining) {
+                    found = static_cast<int>(i);
+                    foundRemaining = distance;
+                }
+            }
+            board.unmakeMove(undo);
+            if (attacking && found >= 0)
+                break;
+        }
+        if (found < 0)
+            break;
+        line.push_back(moves[found]);
+        played.emplace_back();
+        board.makeMove(moves[found], played.back());
+        remaining = foundRemaining;
+    }
+    while (!played.empty()) {
+        board.unmakeMove(played.back());
+        played.pop_back();
+    }
+}
+
+Move MateSearch::mostPromisingMove(int remaining) {
+    std::vector<Move> moves = board.generateLegalMoves();
+    Move best;
+    uint32_t bestProof = INFINITE + 1;
+    for (const Move& move : moves) {
+        uint32_t proof, disproof;
+        MoveHistory undo;
+        board.makeMove(move, undo);
+        lookup(remaining - 1, proof, disproof);
+        board.unmakeMove(undo);
+        if (proof < bestProof) {
+            bestProof = proof;
+            best = move;
+        }
+    }
+    return best;
+}
+
+MateStatus MateSearch::solve() {
+    startTimeMs = limits.startTimeMs > 0 ? limits.startTimeMs : Search::clockMs();
+    line.clear();
+    mateMoves = 0;
+    bestMove = Move();
+
+    MateStatus status = MATE_NONE;
+    for (int moves = 1; moves <= maxMoves; moves++) {
+        int remaining = 2 * moves - 1;
+        uint32_t proof, disproof;
+        expand(remaining, INFINITE, INFINITE, proof, disproof);
+        bestMove = mostPromisingMove(remaining);
+
+        std::ostringstream info;
+        info << "info depth " << remaining << " nodes " << nodes
+             << " time " << Search::clockMs() - startTimeMs;
+        if (aborted) {
+            status = MATE_UNKNOWN;
+            emit(info.str() + '\n');
+            break;
+        }
+        if (proof == 0) {
+            // A stop while the line is walked leaves it short; the mate
+            // itself is still proven.
+            extractLine(remaining);
+            status = MATE_FOUND;
+            mateMoves = moves;
+            if (!line.empty())
+                bestMove = line[0];
+            info << " score mate " << moves << " pv";
+            for (const Move& move : line)
+                info << ' ' << moveToUCI(move);
+            emit(info.str() + '\n');
+            break;
+        }
+        emit(info.str() + '\n');
+    }
+
+    if (status == MATE_NONE) {
+        std::ostringstream info;
+        info << "info string no mate in " << maxMoves << '\n';
+        emit(info.str());
+    }
+
+    // UCI forbids reporting a move in infinite mode until stop arrives.
+    if (limits.infinite) {
+        std::unique_lock<std::mutex> guard(waitLock);
+        released.wait(guard, [this]() { return stopRequested.load(); });
+    }
+    return status;
+}
@@ -1,136 +1,186 @@
 #include "../headers/board.h"
+#include "../headers/zobrist.h"
+#include "../headers/color_traits.h"
 
-void Board::makeMove(const Move& move) {
-    MoveHistory history;
-    history.move = move;
-    history.oldEnPassant = enPassantTarget;
-    history.oldCanCastleKingsideWhite = canCastleKingsideWhite;
-    history.oldCanCastleQueensideWhite = canCastleQueensideWhite;
-    history.oldCanCastleKingsideBlack = canCastleKingsideBlack;
-    history.oldCanCastleQueensideBlack = canCastleQueensideBlack;
-    
-    history.movedPiece = board[move.from];
-    history.capturedPiece = board[move.to];
-    
-    if (move.isCastling) {
-        if (move.to == move.from + 2) { // kingside
-            history.rookFrom = move.from + 3;
-            history.rookTo = move.from + 1;
-        } else { // queenside
-            history.rookFrom = move.from - 4;
-            history.rookTo = move.from - 1;
-        }
-        history.rookPiece = board[history.rookFrom];
-    }
-    
-    int fromPiece = board[move.from];
-    int color = fromPiece & (Piece::White | Piece::Black);
-    int pieceType = fromPiece & 7;
-    
-    if (pieceType == Piece::King) {
-        if (color == Piece::White) {
-            canCastleKingsideWhite = false;
-            canCastleQueensideWhite = false;
-        } else {
-            canCastleKingsideBlack = false;
-            canCastleQueensideBlack = false;
-        }
-    } else if (pieceType == Piece::Rook) {
-        if (color == Piece::White) {
-            if (move.from == 7 * 8 + 7) 
-                canCastleKingsideWhite = false;
-            else if (move.from == 7 * 8 + 0) 
-                canCastleQueensideWhite = false;
-        } else {
-            if (move.from == 0 * 8 + 7) 
-                canCastleKingsideBlack = false;
-            else if (move.from == 0 * 8 + 0) 
-                canCastleQueensideBlack = false;
-        }
+namespace {
+
+// Castling rights that survive a move touching each square: moving from or
+// capturing on a king or rook home square clears the matching rights.
+struct CastlingMaskTable {
+    int mask[64];
+    CastlingMaskTable() {
+        for (int i = 0; i < 64; i++)
+            mask[i] = CastleWhiteKingside | CastleWhiteQueenside | CastleBlackKingside | CastleBlackQueenside;
+        mask[7 * 8 + 4] &= ~(CastleWhiteKingside | CastleWhiteQueenside);
+        mask[7 * 8 + 7] &= ~CastleWhiteKingside;
+        mask[7 * 8 + 0] &= ~CastleWhiteQueenside;
+        mask[0 * 8 + 4] &= ~(CastleBlackKingside | CastleBlackQueenside);
+        mask[0 * 8 + 7] &= ~CastleBlackKingside;
+        mask[0 * 8 + 0] &= ~CastleBlackQueenside;
     }
-    
-    if (move.capturePiece != Piece::None && ((move.capturePiece & 7) == Piece::Rook)) {
-        int capturedSquare = move.to;
-        int capturedColor = move.capturePiece & (Piece::White | Piece::Black);
-        if (capturedColor == Piece::White) {
-            if (capturedSquare == 7 * 8 + 7)
-                canCastleKingsideWhite = false;
-            else if (capturedSquare == 7 * 8 + 0)
-                canCastleQueensideWhite = false;
-        } else {
-            if (capturedSquare == 0 * 8 + 7)
-                canCastleKingsideBlack = false;
-            else if (capturedSquare == 0 * 8 + 0)
-                canCastleQueensideBlack = false;
-        }
+};
+
+const CastlingMaskTable castlingMasks;
+
+// Rook squares of a castling move, from the king's move.
+void castlingRookSquares(const Move& move, int& rookFrom, int& rookTo) {
+    if (move.to == move.from + 2) { // kingside
+        rookFrom = move.from + 3;
+        rookTo = move.from + 1;
+    } else { // queenside
+        rookFrom = move.from - 4;
+        rookTo = move.from - 1;
     }
-    
+}
+
+}
+
+void Board::makeMove(const Move& move) {
+    if (sideToMove == Piece::White)
+        makeMove<Piece::White>(move);
+    else
+        makeMove<Piece::Black>(move);
+}
+
+void Board::makeMove(const Move& move, MoveHistory& undo) {
+    if (sideToMove == Piece::White)
+        makeMove<Piece::White>(move, undo);
+    else
+        makeMove<Piece::Black>(move, undo);
+}
+
+template<int Us>
+void Board::makeMove(const Move& move, MoveHistory& undo) {
+    undo.move = move;
+    undo.capturedPiece = board[move.to];
+    undo.oldEnPassant = enPassantTarget;
+    undo.oldCastlingRights = castlingRights;
+    undo.oldHalfmoveClock = halfmoveClock;
+    undo.oldZobristKey = zobristKey;
+    makeMove<Us>(move);
+}
+
+template<int Us>
+void Board::makeMove(const Move& move) {
+    typedef ColorTraits<Us> Traits;
+    keyHistory[historyCount % KEY_HISTORY_SIZE] = zobristKey;
+    historyCount++;
+    attacksValid = false;
+
+    int movedPiece = board[move.from];
+    int capturedPiece = board[move.to];
+    int pieceType = movedPiece & 7;
+
+    // Remove the old castling rights and en passant file from the key;
+    // the updated ones are hashed back in once the move is applied.
+    zobristKey ^= Zobrist::castlingKeys[castlingRights];
+    if (enPassantTarget != -1)
+        zobristKey ^= Zobrist::enPassantKeys[enPassantTarget % 8];
+
+    castlingRights &= castlingMasks.mask[move.from] & castlingMasks.mask[move.to];
+
     // Handle castling: move the rook.
     if (move.isCastling) {
-        board[history.rookTo] = board[history.rookFrom];
-        board[history.rookFrom] = Piece::None;
+        int rookFrom, rookTo;
+        castlingRookSquares(move, rookFrom, rookTo);
+        int rookPiece = board[rookFrom];
+        zobristKey ^= Zobrist::pieceKeys[rookPiece][rookFrom];
+        zobristKey ^= Zobrist::pieceKeys[rookPiece][rookTo];
+        board[rookTo] = rookPiece;
+        board[rookFrom] = Piece::None;
     }
-    
+
     // Handle en passant.
     if (move.isEnPassant) {
-        int capturedPawnSquare = move.to + ((color == Piece::White) ? 8 : -8);
+        int capturedPawnSquare = move.to - Traits::Forward;
+        zobristKey ^= Zobrist::pieceKeys[board[capturedPawnSquare]][capturedPawnSquare];
         board[capturedPawnSquare] = Piece::None;
         enPassantTarget = -1;
-    } else if (pieceType == Piece::Pawn && abs(move.to - move.from) == 16) {
-        enPassantTarget = move.from + (move.to - move.from) / 2;
+    } else if (pieceType == Piece::Pawn && move.to - move.from == 2 * Traits::Forward) {
+        enPassantTarget = move.from + Traits::Forward;
     } else {
         enPassantTarget = -1;
     }
-    
+
     // Handle promotion.
-    if (move.isPromotion)
-        fromPiece = color | move.promotionPiece;
-    
+    int toPiece = move.isPromotion ? (Us | move.promotionPiece) : movedPiece;
+
     // Make the move.
+    zobristKey ^= Zobrist::pieceKeys[movedPiece][move.from];
+    if (capturedPiece != Piece::None)
+        zobristKey ^= Zobrist::pieceKeys[capturedPiece][move.to];
+    zobristKey ^= Zobrist::pieceKeys[toPiece][move.to];
     board[move.from] = Piece::None;
-    board[move.to] = fromPiece;
+    board[move.to] = toPiece;
+
+    // Captures and pawn moves are irreversible and reset the fifty-move count.
+    if (pieceType == Piece::Pawn || capturedPiece != Piece::None)
+        halfmoveClock = 0;
+    else
+        halfmoveClock++;
 
     moveCount++;
-    
-    sideToMove = (sideToMove == Piece::White) ? Piece::Black : Piece::White;
-    
-    this->moveHistoryStack.push_back(history);
+
+    sideToMove = Traits::Them;
+
+    zobristKey ^= Zobrist::castlingKeys[castlingRights];
+    if (enPassantTarget != -1)
+        zobristKey ^= Zobrist::enPassantKeys[enPassantTarget % 8];
+    zobristKey ^= Zobrist::sideKey;
+}
+
+void Board::unmakeMove(const MoveHistory& undo) {
+    // The side that played the last move is the one not on move now.
+    if (sideToMove == Piece::White)
+        unmakeMove<Piece::Black>(undo);
+    else
+        unmakeMove<Piece::White>(undo);
 }
 
-void Board::unmakeMove() {
-    if (moveHistoryStack.empty())
-        return; 
-    
-    MoveHistory history = this->moveHistoryStack.back();
-    this->moveHistoryStack.pop_back();
-    Move move = history.move;
-    
-    sideToMove = (sideToMove == Piece::White) ? Piece::Black : Piece::White;
-    
+template<int Us>
+void Board::unmakeMove(const MoveHistory& undo) {
+    attacksValid = false;
+    const Move& move = undo.move;
+
+    sideToMove = Us;
 
     int movedPiece = board[move.to];
     if (move.isPromotion)
-        movedPiece = (movedPiece & (Piece::White | Piece::Black)) | Piece::Pawn;
-    
+        movedPiece = Us | Piece::Pawn;
+
     board[move.from] = movedPiece;
-    board[move.to] = history.capturedPiece;
-    
+    board[move.to] = undo.capturedPiece;
+
     if (move.isCastling) {
-        board[history.rookFrom] = history.rookPiece;
-        board[history.rookTo] = Piece::None;
+        int rookFrom, rookTo;
+        castlingRookSquares(move, rookFrom, rookTo);
+        board[rookFrom] = board[rookTo];
+        board[rookTo] = Piece::None;
     }
-    
+
     if (move.isEnPassant) {
-        int capturedPawnSquare = move.to + ((sideToMove == Piece::White) ? 8 : -8);
+        int capturedPawnSquare = move.to - ColorTraits<Us>::Forward;
         board[capturedPawnSquare] = move.capturePiece;
     }
-    
-    enPassantTarget = history.oldEnPassant;
-    
-    canCastleKingsideWhite = history.oldCanCastleKingsideWhite;
-    canCastleQueensideWhite = history.oldCanCastleQueensideWhite;
-    canCastleKingsideBlack = history.oldCanCastleKingsideBlack;
-    canCastleQueensideBlack = history.oldCanCastleQueensideBlack;
+
+    enPassantTarget = undo.oldEnPassant;
+    castlingRights = undo.oldCastlingRights;
+    halfmoveClock = undo.oldHalfmoveClock;
+    zobristKey = undo.oldZobristKey;
+    historyCount--;
 
     moveCount--;
-}
\ No newline at end of file
+}
+
+template void Board::makeMove<Piece::White>(const Move&);
+template void Board::makeMove<Piece::Black>(const Move&);
+template void Board::makeMove<Piece::White>(const Move&, MoveHistory&);
+template void Board::makeMove<Piece::Black>(const Move&, MoveHistory&);
+template void Board::unmakeMove<Piece::White>(const MoveHistory&);
+template void Board::unmakeMove<Piece::Black>(const MoveHistory&);
+
+void Board::restoreState(const BoardState& state) {
+    static_cast<BoardState&>(*this) = state;
+    historyCount--;
+    attacksValid = false;
+}
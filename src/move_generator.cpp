@@ -1,10 +1,14 @@
 #include "../headers/board.h"
+#include "../headers/color_traits.h"
+#include "../headers/attack_tables.h"
 
-std::vector<Move> Board::generatePawnMoves(int square, int color) {
+template<int Us>
+std::vector<Move> Board::generatePawnMoves(int square) {
+    typedef ColorTraits<Us> Traits;
     std::vector<Move> moves;
-    int direction = (color == Piece::White) ? -8 : 8;
+    const int direction = Traits::Forward;
     int forward = square + direction;
-    bool isPromotionRank = (color == Piece::White) ? (forward < 8) : (forward >= 56);
+    bool isPromotionRank = (forward / 8 == Traits::PromotionRank);
 
     // Forward moves
     if (forward >= 0 && forward < 64 && board[forward] == Piece::None) {
@@ -13,8 +17,7 @@ std::vector<Move> Board::generatePawnMoves(int square, int color) {
                 moves.push_back(Move(square, forward, Piece::None, true, false, promo, false));
         } else {
             moves.push_back(Move(square, forward, Piece::None, false, false, Piece::None, false));
-            int startRank = (color == Piece::White) ? 6 : 1;
-            if (square / 8 == startRank) {
+            if (square / 8 == Traits::StartRank) {
                 int doubleForward = forward + direction;
                 if (doubleForward >= 0 && doubleForward < 64 && board[doubleForward] == Piece::None)
                     moves.push_back(Move(square, doubleForward, Piece::None, false, false, Piece::None, false));
@@ -23,7 +26,7 @@ std::vector<Move> Board::generatePawnMoves(int square, int color) {
     }
 
     // Captures
-    std::vector<int> captureOffsets = {direction - 1, direction + 1};
+    static constexpr int captureOffsets[2] = {direction - 1, direction + 1};
     for (int offset : captureOffsets) {
         int target = square + offset;
         if (target < 0 || target >= 64) continue;
@@ -33,14 +36,13 @@ std::vector<Move> Board::generatePawnMoves(int square, int color) {
 
         bool isEp = (target == enPassantTarget);
         if (isEp) {
-            int requiredPawn = (color == Piece::White) ? (Piece::Pawn | Piece::Black) : (Piece::Pawn | Piece::White);
             int pawnSquare = target - direction;
-            if (board[pawnSquare] != requiredPawn)
+            if (board[pawnSquare] != (Piece::Pawn | Traits::Them))
                 continue; // Skip if no pawn to capture
         }
 
-        int capturedPiece = isEp ? (Piece::Pawn | (color == Piece::White ? Piece::Black : Piece::White)) : board[target];
-        if (isEp || (board[target] != Piece::None && ((board[target] & (Piece::White | Piece::Black)) != color))) {
+        int capturedPiece = isEp ? (Piece::Pawn | Traits::Them) : board[target];
+        if (isEp || (board[target] & Traits::Them)) {
             if (isPromotionRank) {
                 for (int promo : {Piece::Queen, Piece::Rook, Piece::Bishop, Piece::Knight})
                     moves.push_back(Move(square, target, capturedPiece, true, isEp, promo, false));
@@ -53,26 +55,21 @@ std::vector<Move> Board::generatePawnMoves(int square, int color) {
     return moves;
 }
 
-std::vector<Move> Board::generateKnightMoves(int square, int color) {
+template<int Us>
+std::vector<Move> Board::generateKnightMoves(int square) {
     std::vector<Move> moves;
-    std::vector<int> offsets = {-17, -15, -10, -6, 6, 10, 15, 17};
-    for (int offset : offsets) {
-        int target = square + offset;
-        if (target < 0 || target >= 64) continue;
-        int dx = abs((target % 8) - (square % 8));
-        int dy = abs((target / 8) - (square / 8));
-        // Valid knight moves are (1,2) or (2,1)
-        if (!((dx == 1 && dy == 2) || (dx == 2 && dy == 1)))
-            continue;
-        if (board[target] == Piece::None || ((board[target] & (Piece::White | Piece::Black)) != color))
+    for (uint64_t targets = stepAttacks.knight[square]; targets; targets &= targets - 1) {
+        int target = __builtin_ctzll(targets);
+        if (!(board[target] & Us))
             moves.push_back(Move(square, target, board[target], false, false, Piece::None, false));
     }
     return moves;
 }
 
-std::vector<Move> Board::generateRookMoves(int square, int color) {
+template<int Us>
+std::vector<Move> Board::generateRookMoves(int square) {
     std::vector<Move> moves;
-    std::vector<int> dirs = {-8, 8, -1, 1};
+    static constexpr int dirs[4] = {-8, 8, -1, 1};
     for (int dir : dirs) {
         for (int step = 1;; step++) {
             int target = square + dir * step;
@@ -82,7 +79,7 @@ std::vector<Move> Board::generateRookMoves(int square, int color) {
             if ((dir == -1 || dir == 1) && (target / 8 != square / 8))
                 break;
             if (board[target] != Piece::None) {
-                if ((board[target] & (Piece::White | Piece::Black)) != color)
+                if (board[target] & ColorTraits<Us>::Them)
                     moves.push_back(Move(square, target, board[target], false, false, Piece::None, false));
                 break;
             }
@@ -92,9 +89,10 @@ std::vector<Move> Board::generateRookMoves(int square, int color) {
     return moves;
 }
 
-std::vector<Move> Board::generateBishopMoves(int square, int color) {
+template<int Us>
+std::vector<Move> Board::generateBishopMoves(int square) {
     std::vector<Move> moves;
-    std::vector<int> dirs = {-9, -7, 7, 9};
+    static constexpr int dirs[4] = {-9, -7, 7, 9};
     for (int dir : dirs) {
         for (int step = 1;; step++) {
             int target = square + dir * step;
@@ -105,7 +103,7 @@ std::vector<Move> Board::generateBishopMoves(int square, int color) {
             if (dx != dy)
                 break;
             if (board[target] != Piece::None) {
-                if ((board[target] & (Piece::White | Piece::Black)) != color)
+                if (board[target] & ColorTraits<Us>::Them)
                     moves.push_back(Move(square, target, board[target], false, false, Piece::None, false));
                 break;
             }
@@ -115,39 +113,39 @@ std::vector<Move> Board::generateBishopMoves(int square, int color) {
     return moves;
 }
 
-std::vector<Move> Board::generateQueenMoves(int square, int color) {
-    std::vector<Move> moves = generateRookMoves(square, color);
-    std::vector<Move> bishopMoves = generateBishopMoves(square, color);
+template<int Us>
+std::vector<Move> Board::generateQueenMoves(int square) {
+    std::vector<Move> moves = generateRookMoves<Us>(square);
+    std::vector<Move> bishopMoves = generateBishopMoves<Us>(square);
     moves.insert(moves.end(), bishopMoves.begin(), bishopMoves.end());
     return moves;
 }
 
-std::vector<Move> Board::generateKingMoves(int square, int color, bool canCastleK, bool canCastleQ) {
+template<int Us>
+std::vector<Move> Board::generateKingMoves(int square) {
+    typedef ColorTraits<Us> Traits;
     std::vector<Move> moves;
-    std::vector<int> dirs = {-9, -8, -7, -1, 1, 7, 8, 9};
-    for (int dir : dirs) {
-        int target = square + dir;
-        if (target < 0 || target >= 64)
-            continue;
-        int dx = abs((target % 8) - (square % 8));
-        int dy = abs((target / 8) - (square / 8));
-        if (dx > 1 || dy > 1)
-            continue;
-        if (board[target] == Piece::None || ((board[target] & (Piece::White | Piece::Black)) != color))
+    for (uint64_t targets = stepAttacks.king[square]; targets; targets &= targets - 1) {
+        int target = __builtin_ctzll(targets);
+        if (!(board[target] & Us))
             moves.push_back(Move(square, target, board[target], false, false, Piece::None, false));
     }
 
-    int rank = (color == Piece::White) ? 7 : 0;
-    int opponent = (color == Piece::White) ? Piece::Black : Piece::White;
-    bool kingInCheck = isKingInCheck(color);
+    const int rank = Traits::BackRank;
+    bool canCastleK = castlingRights & Traits::KingsideCastle;
+    bool canCastleQ = castlingRights & Traits::QueensideCastle;
+    if (!canCastleK && !canCastleQ)
+        return moves;
+    const uint64_t enemyAttacks = attackInfo().enemyAttacks;
+    bool kingInCheck = (enemyAttacks & squareBit(square)) != 0;
 
     // Kingside castling: king moves two squares right.
     if (canCastleK && !kingInCheck) {
         int rookSquare = rank * 8 + 7;
-        if ((board[rookSquare] & (color | Piece::Rook)) == (color | Piece::Rook)) {
+        if ((board[rookSquare] & (Us | Piece::Rook)) == (Us | Piece::Rook)) {
             if (board[rank*8+5] == Piece::None && board[rank*8+6] == Piece::None &&
-                !isSquareAttacked(rank*8+5, opponent) &&
-                !isSquareAttacked(rank*8+6, opponent))
+                !(enemyAttacks & squareBit(rank*8+5)) &&
+                !(enemyAttacks & squareBit(rank*8+6)))
             {
                 moves.push_back(Move(square, rank*8+6, Piece::None, false, false, Piece::None, true));
             }
@@ -157,10 +155,10 @@ std::vector<Move> Board::generateKingMoves(int square, int color, bool canCastle
     // Queenside castling: king moves two squares left.
     if (canCastleQ && !kingInCheck) {
         int rookSquare = rank * 8;
-        if ((board[rookSquare] & (color | Piece::Rook)) == (color | Piece::Rook)) {
+        if ((board[rookSquare] & (Us | Piece::Rook)) == (Us | Piece::Rook)) {
             if (board[rank*8+1] == Piece::None && board[rank*8+2] == Piece::None && board[rank*8+3] == Piece::None &&
-                !isSquareAttacked(rank*8+2, opponent) &&
-                !isSquareAttacked(rank*8+3, opponent))
+                !(enemyAttacks & squareBit(rank*8+2)) &&
+                !(enemyAttacks & squareBit(rank*8+3)))
             {
                 moves.push_back(Move(square, rank*8+2, Piece::None, false, false, Piece::None, true));
             }
@@ -169,3 +167,16 @@ std::vector<Move> Board::generateKingMoves(int square, int color, bool canCastle
 
     return moves;
 }
+
+template std::vector<Move> Board::generatePawnMoves<Piece::White>(int);
+template std::vector<Move> Board::generatePawnMoves<Piece::Black>(int);
+template std::vector<Move> Board::generateKnightMoves<Piece::White>(int);
+template std::vector<Move> Board::generateKnightMoves<Piece::Black>(int);
+template std::vector<Move> Board::generateRookMoves<Piece::White>(int);
+template std::vector<Move> Board::generateRookMoves<Piece::Black>(int);
+template std::vector<Move> Board::generateBishopMoves<Piece::White>(int);
+template std::vector<Move> Board::generateBishopMoves<Piece::Black>(int);
+template std::vector<Move> Board::generateQueenMoves<Piece::White>(int);
+template std::vector<Move> Board::generateQueenMoves<Piece::Black>(int);
+template std::vector<Move> Board::generateKingMoves<Piece::White>(int);
+template std::vector<Move> Board::generateKingMoves<Piece::Black>(int);
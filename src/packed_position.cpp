@@ -0,0 +1,102 @@
+#include "../headers/packed_position.h"
+#include <algorithm>
+
+static_assert(sizeof(PackedPosition) == PACKED_POSITION_SIZE, "records are written as raw bytes");
+
+namespace {
+
+// Records read per file access.
+const size_t READ_BLOCK_RECORDS = 4096;
+const int NO_EN_PASSANT = 64;
+
+}
+
+void packPosition(const Board& board, int score, int result, PackedPosition& packed) {
+    std::fill(packed.bytes, packed.bytes + PACKED_POSITION_SIZE, 0);
+    uint64_t occupancy = 0;
+    int count = 0;
+    for (int square = 0; square < 64; square++) {
+        int piece = board.board[square];
+        if (piece == Piece::None)
+            continue;
+        occupancy |= 1ULL << square;
+        int nibble = (piece & 7) | ((piece & Piece::Black) ? 8 : 0);
+        packed.bytes[8 + count / 2] |= static_cast<uint8_t>(nibble << (4 * (count % 2)));
+        count++;
+    }
+    for (int i = 0; i < 8; i++)
+        packed.bytes[i] = static_cast<uint8_t>(occupancy >> (8 * i));
+
+    packed.bytes[24] = static_cast<uint8_t>((board.sideToMove == Piece::Black ? 1 : 0) | (board.castlingRights << 1));
+    packed.bytes[25] = static_cast<uint8_t>(board.enPassantTarget == -1 ? NO_EN_PASSANT : board.enPassantTarget);
+    packed.bytes[26] = static_cast<uint8_t>(std::min(board.halfmoveClock, 255));
+    int plies = std::min(board.moveCount, 0xFFFF);
+    packed.bytes[27] = static_cast<uint8_t>(plies);
+    packed.bytes[28] = static_cast<uint8_t>(plies >> 8);
+    uint16_t clamped = static_cast<uint16_t>(static_cast<int16_t>(std::max(-32767, std::min(32767, score))));
+    packed.bytes[29] = static_cast<uint8_t>(clamped);
+    packed.bytes[30] = static_cast<uint8_t>(clamped >> 8);
+    packed.bytes[31] = static_cast<uint8_t>(result);
+}
+
+bool unpackPosition(const PackedPosition& packed, Board& board, int& score, int& result) {
+    uint64_t occupancy = 0;
+    for (int i = 0; i < 8; i++)
+        occupancy |= static_cast<uint64_t>(packed.bytes[i]) << (8 * i);
+
+    BoardState state;
+    std::fill(state.board, state.board + 64, Piece::None);
+    int count = 0;
+    for (int square = 0; square < 64; square++) {
+        if (!(occupancy & (1ULL << square)))
+            continue;
+        if (count == 32)
+            return false;
+        int nibble = (packed.bytes[8 + count / 2] >> (4 * (count % 2))) & 15;
+        int type = nibble & 7;
+        if (type < Piece::King || type > Piece::Queen)
+            return false;
+        state.board[square] = static_cast<uint8_t>(type | ((nibble & 8) ? Piece::Black : Piece::White));
+        count++;
+    }
+
+    int enPassant = packed.bytes[25];
+    if (enPassant > NO_EN_PASSANT || packed.bytes[31] > 2)
+        return false;
+    state.sideToMove = (packed.bytes[24] & 1) ? Piece::Black : Piece::White;
+    // As in a FEN, the target lies behind a pawn that just moved two
+    // squares: on the sixth rank with White to move, the third with Black.
+    int targetRow = (state.sideToMove == Piece::White) ? 2 : 5;
+    if (enPassant != NO_EN_PASSANT && enPassant / 8 != targetRow)
+        return false;
+    state.castlingRights = (packed.bytes[24] >> 1) & 15;
+    state.enPassantTarget = (enPassant == NO_EN_PASSANT) ? -1 : enPassant;
+    state.halfmoveClock = packed.bytes[26];
+    state.moveCount = packed.bytes[27] | (packed.bytes[28] << 8);
+    state.zobristKey = 0;
+    board.setState(state);
+
+    score = static_cast<int16_t>(packed.bytes[29] | (packed.bytes[30] << 8));
+    result = packed.bytes[31];
+    return true;
+}
+
+PackedPositionReader::PackedPositionReader(const std::string& file)
+    : in(file, std::ios::binary), block(READ_BLOCK_RECORDS), blockSize(0), position(0) {
+}
+
+bool PackedPositionReader::next(Board& board, int& score, int& result) {
+    for (;;) {
+        if (position == blockSize) {
+            if (!in)
+                return false;
+            in.read(reinterpret_cast<char*>(block.data()), READ_BLOCK_RECORDS * PACKED_POSITION_SIZE);
+            blockSize = static_cast<size_t>(in.gcount()) / PACKED_POSITION_SIZE;
+            position = 0;
+            if (blockSize == 0)
+                return false;
+        }
+        if (unpackPosition(block[position++], board, score, result))
+            return true;
+    }
+}
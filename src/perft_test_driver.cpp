@@ -1,20 +1,118 @@
 #include "../headers/board.h"
+#include "../headers/perft.h"
+#include "../headers/color_traits.h"
 
-int Board::moveGenerationTest(int depth) {
+uint64_t Board::moveGenerationTest(int depth) {
+    return (sideToMove == Piece::White) ? moveGenerationTest<Piece::White>(depth)
+                                        : moveGenerationTest<Piece::Black>(depth);
+}
+
+template<int Us>
+uint64_t Board::moveGenerationTest(int depth) {
     if (depth == 0)
         return 1;
 
-    int nodes = 0;
-    std::vector<Move> moves = generateLegalMoves();
+    uint64_t nodes = 0;
+    std::vector<Move> moves = generateLegalMoves<Us>();
 
     // Loop through each move.
     for (const Move &move : moves) {
-        makeMove(move);
+#ifdef COPY_MAKE
+        BoardState saved = *this;
+        makeMove<Us>(move);
+#else
+        MoveHistory undo;
+        makeMove<Us>(move, undo);
+#endif
+
+        nodes += moveGenerationTest<ColorTraits<Us>::Them>(depth - 1);
+
+#ifdef COPY_MAKE
+        restoreState(saved);
+#else
+        unmakeMove<Us>(undo);
+#endif
+    }
+
+    return nodes;
+}
+
+uint64_t Board::perftHashed(int depth, PerftTable& table) {
+    return (sideToMove == Piece::White) ? perftHashed<Piece::White>(depth, table)
+                                        : perftHashed<Piece::Black>(depth, table);
+}
+
+// Same count as moveGenerationTest, but a depth-1 node is answered by the
+// size of its legal move list instead of playing each move, and subtrees
+// reached again by transposition are looked up in the table.
+template<int Us>
+uint64_t Board::perftHashed(int depth, PerftTable& table) {
+    if (depth == 0)
+        return 1;
+
+    uint64_t nodes = 0;
+    if (depth > 1 && table.probe(zobristKey, depth, nodes))
+        return nodes;
+
+    std::vector<Move> moves = generateLegalMoves<Us>();
+    if (depth == 1)
+        return moves.size();
+
+    for (const Move &move : moves) {
+#ifdef COPY_MAKE
+        BoardState saved = *this;
+        makeMove<Us>(move);
+#else
+        MoveHistory undo;
+        makeMove<Us>(move, undo);
+#endif
 
-        nodes += moveGenerationTest(depth - 1);
+        nodes += perftHashed<ColorTraits<Us>::Them>(depth - 1, table);
 
-        unmakeMove();
+#ifdef COPY_MAKE
+        restoreState(saved);
+#else
+        unmakeMove<Us>(undo);
+#endif
     }
 
+    table.store(zobristKey, depth, nodes);
     return nodes;
-}
\ No newline at end of file
+}
+
+PerftTable::PerftTable(int sizeMB) : mask(0) {
+    resize(sizeMB);
+}
+
+void PerftTable::resize(int sizeMB) {
+    uint64_t bytes = static_cast<uint64_t>(sizeMB < 1 ? 1 : sizeMB) * 1024 * 1024;
+    uint64_t count = 1;
+    while (count * 2 * sizeof(Entry) <= bytes)
+        count *= 2;
+    entries.assign(count, Entry());
+    mask = count - 1;
+    clear();
+}
+
+void PerftTable::clear() {
+    for (Entry& entry : entries) {
+        entry.key = 0;
+        entry.count = 0;
+        entry.depth = 0;
+    }
+}
+
+bool PerftTable::probe(uint64_t key, int depth, uint64_t& count) const {
+    const Entry& entry = entries[(key ^ static_cast<uint64_t>(depth)) & mask];
+    if (entry.key != key || entry.depth != depth)
+        return false;
+    count = entry.count;
+    return true;
+}
+
+void PerftTable::store(uint64_t key, int depth, uint64_t count) {
+    Entry& entry = entries[(key ^ static_cast<uint64_t>(depth)) & mask];
+    entry.key = key;
+    entry.count = count;
+    entry.depth = depth;
+}
@@ -2,112 +2,550 @@
 #include <limits>
 #include <algorithm>
 #include <iostream>
+#include <sstream>
+#include <chrono>
+#include "../headers/utils.h"
+#include "../headers/search_stats.h"
+#include "../headers/color_traits.h"
 
-Search::Search(Board& board, int depth) : board(board), depth(depth) {}
+namespace {
+
+const int HASH_MOVE_SCORE = 1000000;
+const int GOOD_CAPTURE_SCORE = 100000;
+
+}
+
+Search::Search(Board& board, int depth) : Search(board, SearchLimits()) {
+    this->depth = std::max(1, std::min(depth, MAX_SEARCH_DEPTH));
+    limits.depth = this->depth;
+}
+
+Search::Search(Board& board, const SearchLimits& limits, TranspositionTable* table)
+    : board(board), depth(std::max(1, std::min(limits.depth, MAX_SEARCH_DEPTH))), limits(limits), tt(table),
+      timeBudgetMs(0), startTimeMs(0), stopRequested(false), pondering(limits.ponder),
+      aborted(false), nodes(0), rootHistory(0), gameDraws(0), bestScore(0) {
+    timeBudgetMs = timeBudget(limits, board.sideToMove);
+}
+
+long long Search::timeBudget(const SearchLimits& limits, int sideToMove) {
+    int ourTime = (sideToMove == Piece::White) ? limits.whiteTime : limits.blackTime;
+    int ourIncrement = (sideToMove == Piece::White) ? limits.whiteIncrement : limits.blackIncrement;
+    if (limits.moveTime > 0)
+        return limits.moveTime;
+    if (ourTime <= 0)
+        return 0;
+    int movesLeft = limits.movesToGo > 0 ? limits.movesToGo + 1 : 30;
+    long long budget = ourTime / movesLeft + ourIncrement * 3 / 4;
+    // Keep a safety margin for communication overhead.
+    return std::max(1LL, std::min(budget, static_cast<long long>(ourTime) - 50));
+}
+
+void Search::stop() {
+    std::lock_guard<std::mutex> guard(waitLock);
+    stopRequested = true;
+    released.notify_all();
+}
+
+// The opponent played the expected move: keep searching the same tree, but
+// from now on under the normal time budget.
+void Search::ponderHit() {
+    std::lock_guard<std::mutex> guard(waitLock);
+    startClock();
+    pondering = false;
+    released.notify_all();
+}
+
+long long Search::clockMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Search::startClock() {
+    startTimeMs = clockMs();
+}
+
+long long Search::elapsedMs() const {
+    return clockMs() - startTimeMs;
+}
+
+void Search::emit(const std::string& text) {
+    if (output)
+        output(text);
+    else
+        std::cout << text << std::flush;
+}
+
+bool Search::shouldStop() {
+    if (aborted)
+        return true;
+    if (stopRequested)
+        return aborted = true;
+    if (pondering)
+        return false;
+    if (limits.nodes > 0 && nodes >= limits.nodes)
+        return aborted = true;
+    // Reading the clock is comparatively slow, so only poll it periodically.
+    if (timeBudgetMs > 0 && (nodes & 1023) == 0 && elapsedMs() >= timeBudgetMs)
+        return aborted = true;
+    return false;
+}
 
 Move Search::findBestMove() {
+    if (limits.startTimeMs > 0)
+        startTimeMs = limits.startTimeMs;
+    else
+        startClock();
+#ifdef SEARCH_STATS
+    stats.reset();
+    if (!limits.statsTraceFile.empty())
+        trace.open(limits.statsTraceFile, std::ios::app);
+#endif
+    rootHistory = board.historyLength();
+    gameDraws = 0;
+    initRootMoves();
     Move bestMove;
+    ponderMove = Move();
+    bestScore = 0;
     // Iterative deepening: start at depth 1 and increase to maxDepth.
     for (int currentDepth = 1; currentDepth <= depth; ++currentDepth) {
-        bestMove = findBestMoveAtDepth(currentDepth);
-        std::cout << "Completed search at depth " << currentDepth << std::endl;
+        Move move = (board.sideToMove == Piece::White) ? findBestMoveAtDepth<Piece::White>(currentDepth)
+                                                       : findBestMoveAtDepth<Piece::Black>(currentDepth);
+        if (aborted) {
+            // An iteration cut short is not reported. The first one still
+            // gives the move to play, so that a legal move is always returned.
+            if (currentDepth == 1)
+                bestMove = move;
+            break;
+        }
+        bestMove = move;
+        if (!rootMoves.empty()) {
+            bestScore = rootMoves[0].score;
+            ponderMove = (rootMoves[0].pvLength > 1) ? rootMoves[0].pv[1] : ponderMoveFromTable(bestMove);
+        }
+        reportIteration(currentDepth);
+#ifdef SEARCH_STATS
+        if (trace.is_open())
+            stats.writeJson(trace, currentDepth, elapsedMs());
+#endif
+        // Another iteration would not finish in the time left.
+        if (!pondering && timeBudgetMs > 0 && elapsedMs() * 2 >= timeBudgetMs)
+            break;
+    }
+
+    // UCI forbids reporting a move while pondering or in infinite mode until
+    // the GUI sends ponderhit or stop.
+    {
+        std::unique_lock<std::mutex> guard(waitLock);
+        released.wait(guard, [this]() { return stopRequested || !(pondering || limits.infinite); });
     }
+
+#ifdef SEARCH_STATS
+    std::ostringstream report;
+    stats.print(report);
+    emit(report.str());
+#endif
+
     return bestMove;
 }
 
-Move Search::findBestMoveAtDepth(int currentDepth) {
-    bool maximizing = (board.sideToMove == Piece::White);
-    int bestScore = maximizing ? -std::numeric_limits<int>::max() 
-                               : std::numeric_limits<int>::max();
-    Move bestMove;
-    
+void Search::initRootMoves() {
     // Get legal moves and sort them using move heuristic.
     std::vector<Move> legalMoves = board.generateLegalMoves();
-    std::sort(legalMoves.begin(), legalMoves.end(), [this](const Move& a, const Move& b) {
-        return moveHeuristic(a) > moveHeuristic(b);
-    });
-    
+    orderMoves(legalMoves, 0);
+    rootMoves.clear();
     for (const Move& move : legalMoves) {
-        board.makeMove(move);
-        int score = minimax(board, currentDepth - 1,
-                            -std::numeric_limits<int>::max(),
-                            std::numeric_limits<int>::max(),
-                            !maximizing);
-        board.unmakeMove();
-        
-        if (maximizing) {
-            if (score > bestScore) {
-                bestScore = score;
-                bestMove = move;
-            }
-        } else {
-            if (score < bestScore) {
-                bestScore = score;
-                bestMove = move;
+        RootMove rootMove;
+        rootMove.move = move;
+        rootMove.score = 0;
+        rootMove.pv[0] = move;
+        rootMove.pvLength = 1;
+        rootMoves.push_back(rootMove);
+    }
+}
+
+// When the principal variation was cut short by a table hit, the reply
+// stored for the position after the best move is still a good ponder move.
+Move Search::ponderMoveFromTable(const Move& bestMove) {
+    if (!tt || bestMove.from == -1)
+        return Move();
+    Move reply;
+    MoveHistory undo;
+    board.makeMove(bestMove, undo);
+    TTEntry entry;
+    if (tt->probe(board.zobristKey, entry)) {
+        for (const Move& move : board.generateLegalMoves()) {
+            if (TranspositionTable::sameMove(entry.bestMove, move)) {
+                reply = move;
+                break;
             }
         }
     }
-    
-    return bestMove;
+    board.unmakeMove(undo);
+    return reply;
+}
+
+void Search::reportIteration(int currentDepth) {
+    int lines = std::min(limits.multiPV, static_cast<int>(rootMoves.size()));
+    std::ostringstream info;
+    for (int k = 0; k < lines; k++) {
+        const RootMove& rootMove = rootMoves[k];
+        info << "info depth " << currentDepth;
+        if (limits.multiPV > 1)
+            info << " multipv " << (k + 1);
+        info << " score cp " << rootMove.score
+             << " nodes " << nodes << " time " << elapsedMs() << " pv";
+        for (int i = 0; i < rootMove.pvLength; i++) {
+            char uci[UCI_MOVE_BUFFER_SIZE];
+            writeMoveUCI(rootMove.pv[i], uci);
+            info << ' ' << uci;
+        }
+        info << '\n';
+        if (progress) {
+            SearchProgress line = {currentDepth, k + 1, rootMove.score, nodes, elapsedMs(),
+                                   rootMove.pv, rootMove.pvLength};
+            progress(line);
+        }
+    }
+    emit(info.str());
 }
 
-int Search::minimax(Board& board, int depth, int alpha, int beta, bool maximizingPlayer) {
-    if (depth == 0 || isGameOver(board)) {
-        return evaluateBoard(board);
+// Searches every root move once. Moves are kept sorted best-first as they
+// complete; only a move that could still enter the top multiPV lines needs an
+// exact score, so later moves are searched against the current last line's
+// score and fail low cheaply. With multiPV == 1 this is plain alpha-beta.
+template<int Us>
+Move Search::findBestMoveAtDepth(int currentDepth) {
+    const bool maximizing = (Us == Piece::White);
+    int lines = std::max(1, limits.multiPV);
+    STATS_INC_PLY(0);
+
+    for (size_t i = 0; i < rootMoves.size(); i++) {
+        int alpha = -std::numeric_limits<int>::max();
+        int beta = std::numeric_limits<int>::max();
+        if (static_cast<int>(i) >= lines) {
+            int bound = rootMoves[lines - 1].score;
+            if (maximizing)
+                alpha = bound;
+            else
+                beta = bound;
+        }
+
+        const Move move = rootMoves[i].move;
+#ifdef COPY_MAKE
+        BoardState saved = board;
+        board.makeMove<Us>(move);
+#else
+        board.makeMove<Us>(move, undoStack[0]);
+#endif
+        int score = minimax<ColorTraits<Us>::Them>(board, currentDepth - 1, 1, alpha, beta);
+#ifdef COPY_MAKE
+        board.restoreState(saved);
+#else
+        board.unmakeMove<Us>(undoStack[0]);
+#endif
+        if (aborted)
+            break;
+
+        RootMove& rootMove = rootMoves[i];
+        rootMove.score = score;
+        rootMove.pv[0] = move;
+        for (int j = 0; j < pvLength[1]; j++)
+            rootMove.pv[j + 1] = pvTable[1][j];
+        rootMove.pvLength = pvLength[1] + 1;
+
+        // Insert the finished move into the sorted prefix; ties keep the
+        // earlier move, as the previous single-line search did.
+        for (size_t j = i; j > 0; j--) {
+            bool better = maximizing ? (rootMoves[j].score > rootMoves[j - 1].score)
+                                     : (rootMoves[j].score < rootMoves[j - 1].score);
+            if (!better)
+                break;
+            std::swap(rootMoves[j], rootMoves[j - 1]);
+        }
+    }
+
+    return rootMoves.empty() ? Move() : rootMoves[0].move;
+}
+
+template<int Us>
+int Search::minimax(Board& board, int depth, int ply, int alpha, int beta) {
+    const bool maximizingPlayer = (Us == Piece::White);
+    pvLength[ply] = 0;
+    nodes++;
+    STATS_INC_PLY(ply);
+    if (shouldStop())
+        return 0;
+
+    // Repeated and fifty-move positions are draws; there is nothing to search.
+    int repeated = board.lastRepetition();
+    if (repeated >= 0 || board.isFiftyMoveDraw()) {
+        STATS_INC(drawCutoffs);
+        // Repeating a position from before the root, or running out the
+        // fifty-move count, is a draw in this game only.
+        if (repeated < rootHistory || board.isFiftyMoveDraw())
+            gameDraws++;
+        return 0;
+    }
+
+    // Check extension: a side in check has few replies, and cutting the
+    // line off here would misjudge it. Bounded so the ply tables hold.
+    // Done before the table probe, so that probe and store see the same depth.
+    bool inCheck = board.inCheck();
+    if (inCheck && ply + depth < MAX_SEARCH_DEPTH) {
+        STATS_INC(checkExtensions);
+        depth++;
+    }
+
+    uint16_t hashMove = 0;
+    TTEntry entry;
+    if (tt) {
+        STATS_INC(ttProbes);
+    }
+    if (tt && tt->probe(board.zobristKey, entry)) {
+        STATS_INC(ttHits);
+        hashMove = entry.bestMove;
+        if (entry.depth >= depth) {
+            if (entry.flag == TT_EXACT) {
+                STATS_INC(ttCutoffs);
+                return entry.score;
+            }
+            if (entry.flag == TT_LOWER)
+                alpha = std::max(alpha, static_cast<int>(entry.score));
+            else
+                beta = std::min(beta, static_cast<int>(entry.score));
+            if (beta <= alpha) {
+                STATS_INC(ttCutoffs);
+                return entry.score;
+            }
+        }
+    }
+
+    if (depth == 0) {
+        STATS_INC(leafNodes);
+        return quiescence<Us>(board, ply, alpha, beta);
     }
     
-    std::vector<Move> legalMoves = board.generateLegalMoves();
-    if (maximizingPlayer) {
-        int maxEval = -std::numeric_limits<int>::max();
-        for (const Move& move : legalMoves) {
-            board.makeMove(move);
-            int eval = minimax(board, depth - 1, alpha, beta, false);
-            board.unmakeMove();
-            maxEval = std::max(maxEval, eval);
-            alpha = std::max(alpha, eval);
-            if (beta <= alpha) break; // Beta cutoff
+    STATS_INC(mainNodes);
+    std::vector<Move> legalMoves = generateMoves<Us>(board);
+    if (legalMoves.empty()) {
+        int eval = terminalScore<Us>(board);
+        if (tt)
+            tt->store(board.zobristKey, depth, eval, TT_EXACT, Move());
+        return eval;
+    }
+    orderMoves(legalMoves, hashMove);
+
+    int alphaSearched = alpha, betaSearched = beta;
+    long long gameDrawsBefore = gameDraws;
+    int bestEval = maximizingPlayer ? -std::numeric_limits<int>::max()
+                                    : std::numeric_limits<int>::max();
+    Move bestMove;
+    for (size_t moveIndex = 0; moveIndex < legalMoves.size(); moveIndex++) {
+        const Move& move = legalMoves[moveIndex];
+
+        // At the frontier a capture that loses material is not worth a
+        // search, unless it may be the way out of check.
+        if (depth == 1 && moveIndex > 0 && isCapture(move) && !move.isPromotion && !inCheck) {
+            if (board.staticExchange(move) < 0) {
+                STATS_INC(seePrunes);
+                continue;
+            }
         }
-        return maxEval;
-    } else {
-        int minEval = std::numeric_limits<int>::max();
-        for (const Move& move : legalMoves) {
-            board.makeMove(move);
-            int eval = minimax(board, depth - 1, alpha, beta, true);
-            board.unmakeMove();
-            minEval = std::min(minEval, eval);
+
+#ifdef COPY_MAKE
+        BoardState saved = board;
+        board.makeMove<Us>(move);
+#else
+        board.makeMove<Us>(move, undoStack[ply]);
+#endif
+        int eval = minimax<ColorTraits<Us>::Them>(board, depth - 1, ply + 1, alpha, beta);
+#ifdef COPY_MAKE
+        board.restoreState(saved);
+#else
+        board.unmakeMove<Us>(undoStack[ply]);
+#endif
+        if (aborted)
+            return 0;
+
+        bool improved = maximizingPlayer ? (eval > bestEval) : (eval < bestEval);
+        if (improved) {
+            bestEval = eval;
+            bestMove = move;
+            pvTable[ply][0] = move;
+            for (int i = 0; i < pvLength[ply + 1]; i++)
+                pvTable[ply][i + 1] = pvTable[ply + 1][i];
+            pvLength[ply] = pvLength[ply + 1] + 1;
+        }
+        if (maximizingPlayer)
+            alpha = std::max(alpha, eval);
+        else
             beta = std::min(beta, eval);
-            if (beta <= alpha) break; // Alpha cutoff
+        if (beta <= alpha) { // Cutoff
+            STATS_INC(betaCutoffs);
+            if (moveIndex == 0)
+                STATS_INC(firstMoveCutoffs);
+            break;
         }
-        return minEval;
     }
+
+    // A score that rests on a draw of this game alone is not stored: the
+    // table may be shared with other games.
+    if (tt && gameDraws == gameDrawsBefore) {
+        int flag = TT_EXACT;
+        if (bestEval <= alphaSearched)
+            flag = TT_UPPER;
+        else if (bestEval >= betaSearched)
+            flag = TT_LOWER;
+        tt->store(board.zobristKey, depth, bestEval, flag, bestMove);
+    }
+    return bestEval;
 }
 
-int Search::evaluateBoard(Board& board) {
-    if (isGameOver(board)) {
-        if (board.isKingInCheck(board.sideToMove)) {
-            // Checkmate: return a huge value based on which side is in check
-            return (board.sideToMove == Piece::White) 
-                   ? -Evaluator::KING_VALUE * 1000 
-                   : Evaluator::KING_VALUE * 1000;
+// Captures-only search below the horizon, so that leaves are not evaluated
+// in the middle of an exchange. The side to move may stand pat on the static
+// evaluation; captures that lose material by SEE are skipped. A side in
+// check may not stand pat: every evasion is searched, and having none is
+// mate. The horizon node itself was already counted by minimax, so nodes are
+// counted here as each move is made.
+template<int Us>
+int Search::quiescence(Board& board, int ply, int alpha, int beta) {
+    const bool maximizingPlayer = (Us == Piece::White);
+    bool inCheck = board.inCheck();
+    std::vector<std::pair<int, Move>> moves;
+    int bestEval;
+    if (inCheck) {
+        std::vector<Move> evasions = generateMoves<Us>(board);
+        if (evasions.empty())
+            return terminalScore<Us>(board);
+        if (ply >= MAX_SEARCH_DEPTH * 2)
+            return evaluateBoard(board);
+        orderMoves(evasions, 0);
+        for (const Move& move : evasions)
+            moves.push_back(std::make_pair(0, move));
+        bestEval = maximizingPlayer ? -std::numeric_limits<int>::max()
+                                    : std::numeric_limits<int>::max();
+    } else {
+        int standPat = evaluateBoard(board);
+        if (maximizingPlayer) {
+            if (standPat >= beta)
+                return standPat;
+            alpha = std::max(alpha, standPat);
         } else {
-            // Stalemate
+            if (standPat <= alpha)
+                return standPat;
+            beta = std::min(beta, standPat);
+        }
+        if (ply >= MAX_SEARCH_DEPTH * 2)
+            return standPat;
+
+        for (const Move& move : generateCaptures<Us>(board)) {
+            int see = board.staticExchange(move);
+            if (see < 0) {
+                STATS_INC(seePrunes);
+                continue;
+            }
+            moves.push_back(std::make_pair(see, move));
+        }
+        std::stable_sort(moves.begin(), moves.end(),
+                         [](const std::pair<int, Move>& a, const std::pair<int, Move>& b) {
+                             return a.first > b.first;
+                         });
+        bestEval = standPat;
+    }
+
+    for (const auto& scored : moves) {
+#ifdef COPY_MAKE
+        BoardState saved = board;
+        board.makeMove<Us>(scored.second);
+#else
+        board.makeMove<Us>(scored.second, undoStack[ply]);
+#endif
+        nodes++;
+        STATS_INC_PLY(ply + 1);
+        STATS_INC(quiescenceNodes);
+        int eval = shouldStop() ? 0 : quiescence<ColorTraits<Us>::Them>(board, ply + 1, alpha, beta);
+#ifdef COPY_MAKE
+        board.restoreState(saved);
+#else
+        board.unmakeMove<Us>(undoStack[ply]);
+#endif
+        if (aborted)
             return 0;
+
+        if (maximizingPlayer) {
+            bestEval = std::max(bestEval, eval);
+            alpha = std::max(alpha, eval);
+        } else {
+            bestEval = std::min(bestEval, eval);
+            beta = std::min(beta, eval);
         }
+        if (beta <= alpha)
+            break;
     }
+    return bestEval;
+}
+
+// Score of a position with no legal moves.
+template<int Us>
+int Search::terminalScore(Board& board) {
+    if (board.inCheck()) {
+        // Checkmate: return a huge value based on which side is in check
+        return (Us == Piece::White) 
+               ? -Evaluator::KING_VALUE * 1000 
+               : Evaluator::KING_VALUE * 1000;
+    }
+    // Stalemate
+    return 0;
+}
+
+int Search::evaluateBoard(Board& board) {
+    STATS_INC(evalCalls);
+    STATS_TIME(evalNs);
     return Evaluator::evaluate(board);
 }
 
-bool Search::isGameOver(Board& board) {
-    return board.generateLegalMoves().empty();
+bool Search::isCapture(const Move& move) {
+    return move.capturePiece != Piece::None || move.isEnPassant;
+}
+
+template<int Us>
+std::vector<Move> Search::generateMoves(Board& board) {
+    STATS_INC(moveGenCalls);
+    STATS_TIME(moveGenNs);
+    return board.generateLegalMoves<Us>();
+}
+
+template<int Us>
+std::vector<Move> Search::generateCaptures(Board& board) {
+    STATS_INC(moveGenCalls);
+    STATS_TIME(moveGenNs);
+    return board.generateLegalCaptures<Us>();
+}
+
+// Orders moves best-first by moveHeuristic, with the hash move ahead of all.
+void Search::orderMoves(std::vector<Move>& moves, uint16_t hashMove) {
+    std::vector<std::pair<int, Move>> scored;
+    scored.reserve(moves.size());
+    for (const Move& move : moves) {
+        int score = TranspositionTable::sameMove(hashMove, move) ? HASH_MOVE_SCORE : moveHeuristic(move);
+        scored.push_back(std::make_pair(score, move));
+    }
+    std::stable_sort(scored.begin(), scored.end(),
+                     [](const std::pair<int, Move>& a, const std::pair<int, Move>& b) {
+                         return a.first > b.first;
+                     });
+    for (size_t i = 0; i < moves.size(); i++)
+        moves[i] = scored[i].second;
 }
 
 int Search::moveHeuristic(const Move& move) {
     int score = 0;
     
-    // MVV-LVA capture bonus:
-    Piece captured = board.getPieceAt(move.to);
-    if (captured.getType() != Piece::None) {
-        score += Evaluator::pieceValue(captured) - Evaluator::pieceValue(board.getPieceAt(move.from));
+    // Captures that win or hold material by static exchange come before
+    // quiet moves; losing captures go after them.
+    if (isCapture(move)) {
+        int see = board.staticExchange(move);
+        score += (see >= 0) ? GOOD_CAPTURE_SCORE + see : see;
     }
     
     Piece movingPiece = board.getPieceAt(move.from);
@@ -0,0 +1,68 @@
+#include "../headers/search_stats.h"
+
+#ifdef SEARCH_STATS
+
+namespace {
+
+double percent(long long part, long long whole) {
+    return whole > 0 ? 100.0 * part / whole : 0.0;
+}
+
+}
+
+void SearchStats::reset() {
+    for (int i = 0; i < STATS_MAX_PLY; i++)
+        nodesPerPly[i] = 0;
+    mainNodes = leafNodes = quiescenceNodes = 0;
+    betaCutoffs = firstMoveCutoffs = 0;
+    ttProbes = ttHits = ttCutoffs = 0;
+    drawCutoffs = seePrunes = 0;
+    checkExtensions = 0;
+    moveGenCalls = moveGenNs = 0;
+    evalCalls = evalNs = 0;
+}
+
+// Printed as UCI "info string" lines so GUIs pass them through untouched.
+void SearchStats::print(std::ostream& out) const {
+    out << "info string stats nodes main " << mainNodes << " leaf " << leafNodes
+        << " quiescence " << quiescenceNodes << '\n';
+    out << "info string stats nodes per ply";
+    for (int i = 0; i < STATS_MAX_PLY && nodesPerPly[i] > 0; i++)
+        out << ' ' << nodesPerPly[i];
+    out << '\n';
+    out << "info string stats cutoffs " << betaCutoffs
+        << " first-move " << percent(firstMoveCutoffs, betaCutoffs) << "%\n";
+    out << "info string stats tt probes " << ttProbes
+        << " hits " << percent(ttHits, ttProbes) << "%"
+        << " cutoffs " << ttCutoffs << '\n';
+    out << "info string stats pruned draws " << drawCutoffs << " losing captures " << seePrunes << '\n';
+    out << "info string stats check extensions " << checkExtensions << '\n';
+    out << "info string stats movegen calls " << moveGenCalls << " ms " << moveGenNs / 1000000
+        << " eval calls " << evalCalls << " ms " << evalNs / 1000000 << '\n';
+}
+
+void SearchStats::writeJson(std::ostream& out, int depth, long long elapsedMs) const {
+    out << "{\"depth\":" << depth
+        << ",\"timeMs\":" << elapsedMs
+        << ",\"mainNodes\":" << mainNodes
+        << ",\"leafNodes\":" << leafNodes
+        << ",\"quiescenceNodes\":" << quiescenceNodes
+        << ",\"nodesPerPly\":[";
+    for (int i = 0; i < STATS_MAX_PLY && nodesPerPly[i] > 0; i++)
+        out << (i ? "," : "") << nodesPerPly[i];
+    out << "],\"betaCutoffs\":" << betaCutoffs
+        << ",\"firstMoveCutoffs\":" << firstMoveCutoffs
+        << ",\"ttProbes\":" << ttProbes
+        << ",\"ttHits\":" << ttHits
+        << ",\"ttCutoffs\":" << ttCutoffs
+        << ",\"drawCutoffs\":" << drawCutoffs
+        << ",\"seePrunes\":" << seePrunes
+        << ",\"checkExtensions\":" << checkExtensions
+        << ",\"moveGenCalls\":" << moveGenCalls
+        << ",\"moveGenNs\":" << moveGenNs
+        << ",\"evalCalls\":" << evalCalls
+        << ",\"evalNs\":" << evalNs
+        << "}\n";
+}
+
+#endif
@@ -0,0 +1,149 @@
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "../headers/server.h"
+#include "../headers/uci_session.h"
+
+namespace {
+
+// Output from every session on a connection goes through one lock, so lines
+// from concurrent searches never interleave.
+class Connection {
+public:
+    explicit Connection(int fd) : fd(fd) {}
+    ~Connection() { close(fd); }
+
+    void write(const std::string& text) {
+        std::lock_guard<std::mutex> guard(lock);
+        size_t written = 0;
+        while (written < text.size()) {
+            ssize_t n = send(fd, text.data() + written, text.size() - written, MSG_NOSIGNAL);
+            if (n <= 0)
+                return; // the client went away; its sessions end when reading fails
+            written += n;
+        }
+    }
+
+    int descriptor() const { return fd; }
+    // Ends the reader's wait for input, as if the client had gone.
+    void hangUp() { shutdown(fd, SHUT_RDWR); }
+
+private:
+    int fd;
+    std::mutex lock;
+};
+
+// Tags each line of a session's output with its id.
+OutputSink sessionOutput(const std::shared_ptr<Connection>& connection, const std::string& id) {
+    return [connection, id](const std::string& text) {
+        std::string tagged;
+        size_t begin = 0;
+        while (begin < text.size()) {
+            size_t end = text.find('\n', begin);
+            if (end == std::string::npos)
+                end = text.size();
+            tagged += id + ' ' + text.substr(begin, end - begin) + '\n';
+            begin = end + 1;
+        }
+        connection->write(tagged);
+    };
+}
+
+void serveConnection(std::shared_ptr<Connection> connection, WorkerPool& pool, TranspositionTable& table) {
+    std::map<std::string, std::unique_ptr<UciSession>> sessions;
+    std::string buffer;
+    char chunk[4096];
+    for (;;) {
+        ssize_t n = read(connection->descriptor(), chunk, sizeof(chunk));
+        if (n <= 0)
+            break;
+        buffer.append(chunk, n);
+
+        size_t newline;
+        while ((newline = buffer.find('\n')) != std::string::npos) {
+            std::string line = buffer.substr(0, newline);
+            buffer.erase(0, newline + 1);
+            size_t space = line.find(' ');
+            if (space == std::string::npos || space == 0)
+                continue;
+            std::string id = line.substr(0, space);
+
+            auto it = sessions.find(id);
+            if (it == sessions.end()) {
+                std::unique_ptr<UciSession> session(new UciSession(sessionOutput(connection, id), pool, &table));
+                it = sessions.insert(std::make_pair(id, std::move(session))).first;
+            }
+            if (!it->second->handleCommand(line.substr(space + 1)))
+                sessions.erase(it);
+        }
+    }
+    // Nobody is left to read the moves; stop the remaining searches.
+    sessions.clear();
+}
+
+}
+
+int runServer(const std::string& socketPath, int threads, int hashMB) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "invalid socket path: " << socketPath << std::endl;
+        return 1;
+    }
+    std::strcpy(address.sun_path, socketPath.c_str());
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socketPath.c_str());
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, SOMAXCONN) != 0) {
+        std::cerr << "cannot listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    WorkerPool pool(threads);
+    TranspositionTable table(hashMB);
+    std::cerr << "serving on " << socketPath << " with " << threads << " search threads" << std::endl;
+    // Connection threads use the pool and the table, so all of them are
+    // joined before those go. A connection is released once its thread is
+    // done with it, which is when the thread can be joined without waiting.
+    std::vector<std::pair<std::weak_ptr<Connection>, std::thread>> readers;
+    for (;;) {
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        for (size_t i = 0; i < readers.size();) {
+            if (readers[i].first.expired()) {
+                readers[i].second.join();
+                readers[i] = std::move(readers.back());
+                readers.pop_back();
+            } else {
+                i++;
+            }
+        }
+        std::shared_ptr<Connection> connection(new Connection(fd));
+        readers.push_back(std::make_pair(std::weak_ptr<Connection>(connection),
+                                         std::thread(serveConnection, connection, std::ref(pool), std::ref(table))));
+    }
+    close(listener);
+    for (auto& reader : readers) {
+        if (std::shared_ptr<Connection> connection = reader.first.lock())
+            connection->hangUp();
+        reader.second.join();
+    }
+    return 1;
+}
@@ -0,0 +1,88 @@
+#include "../headers/board.h"
+#include "../headers/eval.h"
+#include <algorithm>
+
+namespace {
+
+int exchangeValue(int piece) {
+    switch (piece & 7) {
+        case Piece::Pawn:   return Evaluator::PAWN_VALUE;
+        case Piece::Knight: return Evaluator::KNIGHT_VALUE;
+        case Piece::Bishop: return Evaluator::BISHOP_VALUE;
+        case Piece::Rook:   return Evaluator::ROOK_VALUE;
+        case Piece::Queen:  return Evaluator::QUEEN_VALUE;
+        case Piece::King:   return Evaluator::KING_VALUE;
+        default:            return 0;
+    }
+}
+
+// Index of the cheapest attacker in the list.
+int leastValuableAttacker(const uint8_t* squares, const int* attackerSquares, int count) {
+    int best = 0;
+    for (int i = 1; i < count; i++) {
+        if (exchangeValue(squares[attackerSquares[i]]) < exchangeValue(squares[attackerSquares[best]]))
+            best = i;
+    }
+    return best;
+}
+
+}
+
+// Static exchange evaluation: the material the side to move expects to win
+// (positive) or lose (negative) from the sequence of captures that move starts
+// on its target square, each side always recapturing with its cheapest piece
+// and stopping when continuing would lose material. Pins are ignored.
+int Board::staticExchange(const Move& move) const {
+    uint8_t squares[64];
+    for (int i = 0; i < 64; i++)
+        squares[i] = board[i];
+
+    int target = move.to;
+    int mover = squares[move.from];
+    int side = mover & (Piece::White | Piece::Black);
+
+    int gain[32];
+    int d = 0;
+    gain[0] = exchangeValue(move.isEnPassant ? Piece::Pawn : squares[target]);
+    if (move.isEnPassant)
+        squares[target + ((side == Piece::White) ? 8 : -8)] = Piece::None;
+
+    int pieceOnTarget = move.isPromotion ? (side | move.promotionPiece) : mover;
+    if (move.isPromotion)
+        gain[0] += exchangeValue(move.promotionPiece) - Evaluator::PAWN_VALUE;
+    squares[move.from] = Piece::None;
+    squares[target] = pieceOnTarget;
+
+    int attackerSquares[32];
+    while (d < 31) {
+        side = (side == Piece::White) ? Piece::Black : Piece::White;
+        int count = attackersTo(squares, target, side, attackerSquares);
+        if (count == 0)
+            break;
+        int from = attackerSquares[leastValuableAttacker(squares, attackerSquares, count)];
+        int attacker = squares[from];
+
+        // A king may only recapture if the other side cannot take it back.
+        if ((attacker & 7) == Piece::King) {
+            int opponent = (side == Piece::White) ? Piece::Black : Piece::White;
+            int defenders[32];
+            squares[from] = Piece::None;
+            if (attackersTo(squares, target, opponent, defenders) > 0)
+                break;
+            squares[from] = attacker;
+        }
+
+        d++;
+        gain[d] = exchangeValue(pieceOnTarget) - gain[d - 1];
+        pieceOnTarget = attacker;
+        squares[from] = Piece::None;
+        squares[target] = attacker;
+    }
+
+    // Either side may decline to continue the exchange at any point.
+    while (d > 0) {
+        gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+        d--;
+    }
+    return gain[0];
+}
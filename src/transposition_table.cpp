@@ -0,0 +1,70 @@
+#include "../headers/transposition.h"
+
+TranspositionTable::TranspositionTable(int sizeMB) : mask(0) {
+    resize(sizeMB);
+}
+
+// The entry count is rounded down to a power of two so a key maps to its
+// slot with a mask instead of a division.
+void TranspositionTable::resize(int sizeMB) {
+    uint64_t bytes = static_cast<uint64_t>(sizeMB < 1 ? 1 : sizeMB) * 1024 * 1024;
+    uint64_t count = 1;
+    while (count * 2 * sizeof(Slot) <= bytes)
+        count *= 2;
+    slots.reset(new Slot[count]);
+    mask = count - 1;
+    clear();
+}
+
+void TranspositionTable::clear() {
+    uint64_t empty = packEntry(0, -1, TT_EXACT, 0);
+    for (uint64_t i = 0; i <= mask; i++) {
+        slots[i].check.store(empty, std::memory_order_relaxed);
+        slots[i].data.store(empty, std::memory_order_relaxed);
+    }
+}
+
+// Score in the low 32 bits, then depth, flag and move.
+uint64_t TranspositionTable::packEntry(int score, int depth, int flag, uint16_t bestMove) {
+    return static_cast<uint32_t>(score) |
+           static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 32 |
+           static_cast<uint64_t>(static_cast<uint8_t>(flag)) << 40 |
+           static_cast<uint64_t>(bestMove) << 48;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& entry) const {
+    const Slot& slot = slots[key & mask];
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    uint64_t check = slot.check.load(std::memory_order_relaxed);
+    int8_t depth = static_cast<int8_t>(data >> 32);
+    if ((check ^ data) != key || depth < 0)
+        return false;
+    entry.key = key;
+    entry.score = static_cast<int32_t>(static_cast<uint32_t>(data));
+    entry.depth = depth;
+    entry.flag = static_cast<uint8_t>(data >> 40);
+    entry.bestMove = static_cast<uint16_t>(data >> 48);
+    return true;
+}
+
+// Keeps a deeper result for the same position over a shallower one;
+// any other entry is replaced.
+void TranspositionTable::store(uint64_t key, int depth, int score, int flag, const Move& bestMove) {
+    Slot& slot = slots[key & mask];
+    uint64_t old = slot.data.load(std::memory_order_relaxed);
+    if ((slot.check.load(std::memory_order_relaxed) ^ old) == key && static_cast<int8_t>(old >> 32) > depth)
+        return;
+    uint64_t data = packEntry(score, depth, flag, packMove(bestMove));
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+    slot.data.store(data, std::memory_order_relaxed);
+}
+
+uint16_t TranspositionTable::packMove(const Move& move) {
+    if (move.from < 0)
+        return 0;
+    return static_cast<uint16_t>(move.from | (move.to << 6) | ((move.promotionPiece & 7) << 12));
+}
+
+bool TranspositionTable::sameMove(uint16_t packed, const Move& move) {
+    return packed != 0 && packed == packMove(move);
+}
@@ -0,0 +1,324 @@
+#include <algorithm>
+#include <cstdlib>
+#include "../headers/uci_session.h"
+#include "../headers/utils.h"
+#include "../headers/perft.h"
+
+namespace {
+
+// Depth used by a bare "go" with no limits.
+const int DEFAULT_SEARCH_DEPTH = 4;
+
+SearchLimits parseGoLimits(std::istringstream& iss) {
+    SearchLimits limits;
+    bool bounded = false;
+    std::string token;
+    while (iss >> token) {
+        if (token == "depth")          { iss >> limits.depth; bounded = true; }
+        else if (token == "nodes")     { iss >> limits.nodes; bounded = true; }
+        else if (token == "movetime")  { iss >> limits.moveTime; bounded = true; }
+        else if (token == "wtime")     { iss >> limits.whiteTime; bounded = true; }
+        else if (token == "btime")     { iss >> limits.blackTime; bounded = true; }
+        else if (token == "winc")      iss >> limits.whiteIncrement;
+        else if (token == "binc")      iss >> limits.blackIncrement;
+        else if (token == "movestogo") iss >> limits.movesToGo;
+        else if (token == "mate")      { iss >> limits.mate; bounded = true; }
+        else if (token == "infinite")  { limits.infinite = true; bounded = true; }
+        else if (token == "ponder")    limits.ponder = true;
+    }
+    if (!bounded)
+        limits.depth = DEFAULT_SEARCH_DEPTH;
+    return limits;
+}
+
+// Finds the next space-separated token at or after pos as [begin, end).
+bool nextToken(const std::string& line, size_t& pos, size_t& begin, size_t& end) {
+    while (pos < line.size() && line[pos] == ' ')
+        pos++;
+    begin = pos;
+    while (pos < line.size() && line[pos] != ' ')
+        pos++;
+    end = pos;
+    return begin != end;
+}
+
+bool tokenEquals(const std::string& line, size_t begin, size_t end, const char* word) {
+    return line.compare(begin, end - begin, word) == 0;
+}
+
+// Plays the moves from pos on; stops at the first one that is not legal and
+// returns false.
+bool applyMoves(Board& board, const std::string& line, size_t pos) {
+    size_t begin, end;
+    while (nextToken(line, pos, begin, end)) {
+        Move move;
+        if (!parseLegalUCIMove(board, line.c_str() + begin, static_cast<int>(end - begin), move))
+            return false;
+        board.makeMove(move);
+    }
+    return true;
+}
+
+// Handles "position ...". lastPosition holds the previous command whose moves
+// are already on the board; when the new command only appends moves to it,
+// just those moves are played instead of rebuilding the game from scratch.
+// A command with a bad move leaves lastPosition empty, so the next one is
+// set up from scratch.
+void setPosition(Board& board, const std::string& line, std::string& lastPosition) {
+    size_t pos, begin, end;
+    if (!lastPosition.empty() && line.size() > lastPosition.size() &&
+        line.compare(0, lastPosition.size(), lastPosition) == 0 &&
+        line[lastPosition.size()] == ' ') {
+        pos = lastPosition.size();
+        bool hadMoves = lastPosition.find(" moves") != std::string::npos;
+        bool extends = hadMoves;
+        if (!hadMoves) {
+            size_t next = pos;
+            extends = nextToken(line, next, begin, end) && tokenEquals(line, begin, end, "moves");
+            pos = next;
+        }
+        if (extends) {
+            if (applyMoves(board, line, pos))
+                lastPosition = line;
+            else
+                lastPosition.clear();
+            return;
+        }
+    }
+
+    pos = 0;
+    nextToken(line, pos, begin, end); // "position"
+    if (!nextToken(line, pos, begin, end))
+        return;
+
+    if (tokenEquals(line, begin, end, "startpos")) {
+        board.fenPosition(START_FEN);
+    } else if (tokenEquals(line, begin, end, "fen")) {
+        size_t fenBegin = pos;
+        size_t movesPos = line.find(" moves", fenBegin);
+        size_t fenEnd = (movesPos == std::string::npos) ? line.size() : movesPos;
+        board.fenPosition(line.c_str() + fenBegin, fenEnd - fenBegin);
+        pos = fenEnd;
+    } else {
+        return;
+    }
+
+    bool applied = true;
+    if (nextToken(line, pos, begin, end) && tokenEquals(line, begin, end, "moves"))
+        applied = applyMoves(board, line, pos);
+    if (applied)
+        lastPosition = line;
+    else
+        lastPosition.clear();
+}
+
+}
+
+UciSession::UciSession(const OutputSink& output, WorkerPool& pool, TranspositionTable* sharedTable)
+    : output(output), pool(pool), table(sharedTable), multiPV(1), perftHashMB(0), mateHashMB(64),
+      searchOpenEnded(false), searchRunning(false), queuedJobId(0) {
+    if (!table) {
+        ownTable.reset(new TranspositionTable());
+        table = ownTable.get();
+    }
+    board.fenPosition(START_FEN);
+}
+
+UciSession::~UciSession() {
+    finishSearch(true);
+}
+
+bool UciSession::handleCommand(const std::string& command) {
+    std::string line = command;
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' '))
+        line.pop_back();
+    if (line.empty())
+        return true;
+    std::istringstream iss(line);
+    std::string token;
+    iss >> token;
+
+    if (token == "uci") {
+        std::ostringstream out;
+        out << "id name chessEngine\n";
+        out << "id author Rounak Paul\n";
+        out << "option name Hash type spin default 16 min 1 max 4096\n";
+        out << "option name MultiPV type spin default 1 min 1 max 256\n";
+        out << "option name Ponder type check default false\n";
+        out << "option name PerftHash type spin default 0 min 0 max 4096\n";
+        out << "option name MateHash type spin default 64 min 1 max 4096\n";
+#ifdef SEARCH_STATS
+        out << "option name StatsTrace type string default <empty>\n";
+#endif
+        out << "uciok\n";
+        output(out.str());
+    } else if (token == "perft") {
+        finishSearch(true);
+        int depth = 0;
+        iss >> depth;
+        runPerft(depth);
+    } else if (token == "isready") {
+        output("readyok\n");
+    } else if (token == "setoption") {
+        finishSearch(true);
+        setOption(iss);
+    } else if (token == "ucinewgame") {
+        finishSearch(true);
+        // A shared table holds other games' positions too; leave it be.
+        if (ownTable)
+            ownTable->clear();
+        board.fenPosition(START_FEN);
+        lastPosition.clear();
+    } else if (token == "position") {
+        finishSearch(true);
+        setPosition(board, line, lastPosition);
+    } else if (token == "go") {
+        finishSearch(true);
+        startSearch(iss);
+    } else if (token == "ponderhit") {
+        std::lock_guard<std::mutex> guard(searchLock);
+        if (searchRunning)
+            activeSearch->ponderHit();
+    } else if (token == "stop") {
+        finishSearch(true);
+    } else if (token == "quit") {
+        finishSearch(true);
+        return false;
+    }
+    return true;
+}
+
+void UciSession::endOfInput() {
+    finishSearch(searchOpenEnded);
+}
+
+void UciSession::setOption(std::istringstream& iss) {
+    std::string nameToken, name, valueToken, valueText;
+    iss >> nameToken >> name >> valueToken >> valueText;
+    int value = std::atoi(valueText.c_str());
+    // The size of a shared table is the server's to decide.
+    if (name == "Hash" && ownTable)
+        ownTable->resize(value);
+    else if (name == "MultiPV")
+        multiPV = std::max(1, value);
+    else if (name == "PerftHash")
+        perftHashMB = std::max(0, value);
+    else if (name == "MateHash")
+        mateHashMB = std::max(1, value);
+#ifdef SEARCH_STATS
+    else if (name == "StatsTrace")
+        statsTraceFile = (valueText == "<empty>") ? "" : valueText;
+#endif
+}
+
+void UciSession::runPerft(int depth) {
+    std::ostringstream out;
+    if (perftHashMB > 0) {
+        PerftTable perftTable(perftHashMB);
+        for (int i = 1; i <= depth; i++)
+            out << "depth " << i << ": " << board.perftHashed(i, perftTable) << '\n';
+    } else {
+        for (int i = 1; i <= depth; i++)
+            out << "depth " << i << ": " << board.moveGenerationTest(i) << '\n';
+    }
+    output(out.str());
+}
+
+// The move's clock starts now, even if every worker is busy; the pool runs
+// the search with the earliest deadline first.
+void UciSession::startSearch(std::istringstream& iss) {
+    SearchLimits limits = parseGoLimits(iss);
+    limits.multiPV = multiPV;
+    limits.startTimeMs = Search::clockMs();
+#ifdef SEARCH_STATS
+    limits.statsTraceFile = statsTraceFile;
+#endif
+    if (limits.mate > 0) {
+        startMateSearch(limits);
+        return;
+    }
+    searchOpenEnded = limits.infinite || limits.ponder;
+    activeSearch.reset(new Search(board, limits, table));
+    activeSearch->setOutput(output);
+    long long budget = activeSearch->getTimeBudgetMs();
+    long long deadline = (budget > 0 && !limits.ponder) ? limits.startTimeMs + budget : WorkerPool::NO_DEADLINE;
+
+    Search* search = activeSearch.get();
+    launch(deadline, searchOpenEnded, [this, search]() {
+        Move bestMove = search->findBestMove();
+        reportBestMove(bestMove, search->getPonderMove());
+    });
+}
+
+// "go mate N" runs the proof-number solver with its own table, sized by the
+// MateHash option and freed when the next command arrives.
+void UciSession::startMateSearch(const SearchLimits& limits) {
+    searchOpenEnded = limits.infinite;
+    activeMate.reset(new MateSearch(board, limits.mate, limits, mateHashMB));
+    activeMate->setOutput(output);
+    long long budget = activeMate->getTimeBudgetMs();
+    long long deadline = budget > 0 ? limits.startTimeMs + budget : WorkerPool::NO_DEADLINE;
+
+    MateSearch* search = activeMate.get();
+    launch(deadline, searchOpenEnded, [this, search]() {
+        search->solve();
+        const std::vector<Move>& line = search->getLine();
+        reportBestMove(search->getBestMove(), line.size() > 1 ? line[1] : Move());
+    });
+}
+
+// Open-ended searches get a thread of their own: they hold it until stop
+// arrives, and on the pool they would keep other sessions' timed searches
+// waiting, since those cannot preempt them.
+void UciSession::launch(long long deadline, bool openEnded, const std::function<void()>& job) {
+    searchRunning = true;
+    if (openEnded) {
+        searchThread = std::thread(job);
+    } else {
+        queuedJob = job;
+        queuedJobId = pool.submit(deadline, job);
+    }
+}
+
+// Runs as a search job's last step.
+void UciSession::reportBestMove(const Move& bestMove, const Move& ponderMove) {
+    char moveText[UCI_MOVE_BUFFER_SIZE];
+    writeMoveUCI(bestMove, moveText);
+    std::ostringstream out;
+    out << "bestmove " << moveText;
+    if (ponderMove.from != -1) {
+        writeMoveUCI(ponderMove, moveText);
+        out << " ponder " << moveText;
+    }
+    out << "\nEvaluation: " << Evaluator::evaluate(board) << '\n';
+    output(out.str());
+
+    std::lock_guard<std::mutex> guard(searchLock);
+    searchRunning = false;
+    searchDone.notify_all();
+}
+
+// With stopNow, a running search ends within a few nodes, and one still
+// waiting for a worker is taken back from the pool and run here: told to
+// stop, it reports a move at once.
+void UciSession::finishSearch(bool stopNow) {
+    std::unique_lock<std::mutex> guard(searchLock);
+    if (stopNow) {
+        if (activeSearch)
+            activeSearch->stop();
+        if (activeMate)
+            activeMate->stop();
+        if (searchRunning && queuedJob && pool.cancel(queuedJobId)) {
+            guard.unlock();
+            queuedJob();
+            guard.lock();
+        }
+    }
+    searchDone.wait(guard, [this]() { return !searchRunning; });
+    guard.unlock();
+    if (searchThread.joinable())
+        searchThread.join();
+    queuedJob = nullptr;
+    activeSearch.reset();
+    activeMate.reset();
+}
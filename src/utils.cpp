@@ -1,6 +1,8 @@
 #include "../headers/utils.h"
 #include "../headers/board.h"
 
+const char* const START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
 Piece Board::getPieceAt(int square) const {
     int pieceCode = board[square];
     Piece::Type type = static_cast<Piece::Type>(pieceCode & 0x7);
@@ -9,16 +11,21 @@ Piece Board::getPieceAt(int square) const {
 }
 
 
-std::string squareToString(int square) {
-    int file = square % 8;
-    int rank = square / 8;
-    char fileChar = 'a' + file;
-    char rankChar = '8' - rank;
-    return std::string() + fileChar + rankChar;
+void writeSquare(int square, char* out) {
+    out[0] = static_cast<char>('a' + square % 8);
+    out[1] = static_cast<char>('8' - square / 8);
 }
 
-std::string moveToUCI(const Move& move) {
-    std::string moveStr = squareToString(move.from) + squareToString(move.to);
+int writeMoveUCI(const Move& move, char* out) {
+    // UCI null move, sent when there is no legal move to report.
+    if (move.from < 0 || move.to < 0) {
+        out[0] = out[1] = out[2] = out[3] = '0';
+        out[4] = '\0';
+        return 4;
+    }
+    writeSquare(move.from, out);
+    writeSquare(move.to, out + 2);
+    int length = 4;
     if (move.isPromotion) {
         char promoChar;
         switch (move.promotionPiece) {
@@ -28,7 +35,83 @@ std::string moveToUCI(const Move& move) {
             case Piece::Knight: promoChar = 'n'; break;
             default:            promoChar = 'q';
         }
-        moveStr += promoChar;
+        out[length++] = promoChar;
     }
-    return moveStr;
-}
\ No newline at end of file
+    out[length] = '\0';
+    return length;
+}
+
+std::string squareToString(int square) {
+    char buffer[2];
+    writeSquare(square, buffer);
+    return std::string(buffer, 2);
+}
+
+std::string moveToUCI(const Move& move) {
+    char buffer[UCI_MOVE_BUFFER_SIZE];
+    int length = writeMoveUCI(move, buffer);
+    return std::string(buffer, length);
+}
+
+namespace {
+
+int parseSquare(const char* text) {
+    int file = text[0] - 'a';
+    int rank = '8' - text[1];
+    if (file < 0 || file > 7 || rank < 0 || rank > 7)
+        return -1;
+    return rank * 8 + file;
+}
+
+}
+
+bool parseUCIMove(const Board& board, const char* text, int length, Move& move) {
+    if (length < 4 || length > 5)
+        return false;
+    int from = parseSquare(text);
+    int to = parseSquare(text + 2);
+    if (from < 0 || to < 0)
+        return false;
+
+    int movingPiece = board.board[from];
+    if (movingPiece == Piece::None ||
+        (movingPiece & (Piece::White | Piece::Black)) != board.sideToMove)
+        return false;
+    int pieceType = movingPiece & 7;
+
+    int promotionPiece = Piece::None;
+    if (length == 5) {
+        switch (text[4]) {
+            case 'q': promotionPiece = Piece::Queen; break;
+            case 'r': promotionPiece = Piece::Rook; break;
+            case 'b': promotionPiece = Piece::Bishop; break;
+            case 'n': promotionPiece = Piece::Knight; break;
+            default: return false;
+        }
+    }
+
+    bool isEnPassant = pieceType == Piece::Pawn && to == board.enPassantTarget && (from % 8) != (to % 8);
+    bool isCastling = pieceType == Piece::King && (to - from == 2 || from - to == 2);
+    int captured = board.board[to];
+    if (isEnPassant)
+        captured = Piece::Pawn | (board.sideToMove == Piece::White ? Piece::Black : Piece::White);
+
+    move = Move(from, to, captured, promotionPiece != Piece::None, isEnPassant, promotionPiece, isCastling);
+    return true;
+}
+
+bool parseLegalUCIMove(Board& board, const char* text, int length, Move& move) {
+    return parseUCIMove(board, text, length, move) && board.isLegal(move);
+}
+
+bool insufficientMaterial(const Board& board) {
+    int minors = 0;
+    for (int i = 0; i < 64; i++) {
+        int type = board.board[i] & 7;
+        if (type == Piece::Pawn || type == Piece::Rook || type == Piece::Queen)
+            return false;
+        if (type == Piece::Knight || type == Piece::Bishop)
+            minors++;
+    }
+    return minors <= 1;
+}
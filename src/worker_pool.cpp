@@ -0,0 +1,53 @@
+#include "../headers/worker_pool.h"
+
+WorkerPool::WorkerPool(int threadCount) : stopping(false), nextSequence(0) {
+    for (int i = 0; i < (threadCount < 1 ? 1 : threadCount); i++)
+        threads.push_back(std::thread(&WorkerPool::workerLoop, this));
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+uint64_t WorkerPool::submit(long long deadline, const std::function<void()>& job) {
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        id = nextSequence++;
+        queue.emplace(std::make_pair(deadline, id), job);
+    }
+    wake.notify_one();
+    return id;
+}
+
+bool WorkerPool::cancel(uint64_t id) {
+    std::lock_guard<std::mutex> guard(lock);
+    for (auto it = queue.begin(); it != queue.end(); ++it) {
+        if (it->first.second == id) {
+            queue.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkerPool::workerLoop() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [this]() { return stopping || !queue.empty(); });
+            if (queue.empty())
+                return;
+            job = std::move(queue.begin()->second);
+            queue.erase(queue.begin());
+        }
+        job();
+    }
+}
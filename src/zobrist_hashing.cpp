@@ -0,0 +1,72 @@
+#include "../headers/zobrist.h"
+#include "../headers/board.h"
+#include <random>
+#include <algorithm>
+
+uint64_t Zobrist::pieceKeys[24][64];
+uint64_t Zobrist::castlingKeys[16];
+uint64_t Zobrist::enPassantKeys[8];
+uint64_t Zobrist::sideKey;
+
+void Zobrist::init() {
+    // Fixed seed so keys are identical between runs.
+    std::mt19937_64 rng(0x9E3779B97F4A7C15ULL);
+    for (int p = 0; p < 24; p++)
+        for (int sq = 0; sq < 64; sq++)
+            pieceKeys[p][sq] = rng();
+    for (int i = 0; i < 16; i++)
+        castlingKeys[i] = rng();
+    for (int i = 0; i < 8; i++)
+        enPassantKeys[i] = rng();
+    sideKey = rng();
+}
+
+namespace {
+struct ZobristInitializer {
+    ZobristInitializer() { Zobrist::init(); }
+} zobristInitializer;
+}
+
+uint64_t Board::computeZobristKey() const {
+    uint64_t key = 0;
+    for (int i = 0; i < 64; i++) {
+        if (board[i] != Piece::None)
+            key ^= Zobrist::pieceKeys[board[i]][i];
+    }
+    key ^= Zobrist::castlingKeys[castlingRights];
+    if (enPassantTarget != -1)
+        key ^= Zobrist::enPassantKeys[enPassantTarget % 8];
+    if (sideToMove == Piece::Black)
+        key ^= Zobrist::sideKey;
+    return key;
+}
+
+// A position can only repeat back to the last capture or pawn move, and only
+// with the same side to move, so scan every second key within the halfmove
+// clock, as far back as the ring still holds.
+int Board::lastRepetition() const {
+    int n = historyCount;
+    int limit = n - std::min(halfmoveClock, KEY_HISTORY_SIZE);
+    for (int i = n - 4; i >= 0 && i >= limit; i -= 2) {
+        if (keyHistory[i % KEY_HISTORY_SIZE] == zobristKey)
+            return i;
+    }
+    return -1;
+}
+
+// The game-ending rule: the position has now occurred three times. The
+// search scores a single repetition as a draw already; see lastRepetition.
+bool Board::isThreefoldRepetition() const {
+    int n = historyCount;
+    int limit = n - std::min(halfmoveClock, KEY_HISTORY_SIZE);
+    int count = 1;
+    for (int i = n - 4; i >= 0 && i >= limit; i -= 2) {
+        if (keyHistory[i % KEY_HISTORY_SIZE] == zobristKey && ++count == 3)
+            return true;
+    }
+    return false;
+}
+
+bool Board::isFiftyMoveDraw() const {
+    return halfmoveClock >= 100;
+}
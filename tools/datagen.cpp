@@ -0,0 +1,188 @@
+// Training data generator. Plays fixed-node self-play games on every core
+// and writes each quiet position, with its search score and the game's
+// result, as a 32-byte record (see headers/packed_position.h).
+//
+//   make OPTIMIZE=1 datagen
+//   ./datagen --output data.bin --games 100000 --nodes 5000
+//
+// Games start with a few random moves so that they do not repeat. Positions
+// in check, or where the best move captures or promotes, are left out: their
+// static evaluation says little about the score the search found.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include "../headers/board.h"
+#include "../headers/search.h"
+#include "../headers/transposition.h"
+#include "../headers/packed_position.h"
+#include "../headers/utils.h"
+
+namespace {
+
+// Games still running after this many plies are scored as draws.
+const int MAX_GAME_PLIES = 400;
+// Scores beyond this are mate scores, not evaluations worth learning.
+const int MAX_RECORDED_SCORE = 3000;
+const int TABLE_MB = 16;
+const int REPORT_INTERVAL = 100;
+
+struct DatagenOptions {
+    std::string outputFile;
+    int games = 1000;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    long long nodes = 5000;
+    int randomPlies = 8;
+    unsigned seed = 1;
+};
+
+struct DatagenState {
+    std::atomic<int> nextGame{0};
+    std::mutex lock;
+    std::ofstream out;
+    long long positions = 0;
+    int finishedGames = 0;
+    long long startMs = 0;
+};
+
+// Plays the opening's random moves; false if the game ended during them.
+bool playRandomOpening(Board& board, int plies, std::mt19937& rng) {
+    for (int i = 0; i < plies; i++) {
+        std::vector<Move> moves = board.generateLegalMoves();
+        if (moves.empty())
+            return false;
+        board.makeMove(moves[std::uniform_int_distribution<size_t>(0, moves.size() - 1)(rng)]);
+    }
+    return !board.generateLegalMoves().empty();
+}
+
+// Plays one game and returns its result in half points for White, filling
+// records with the positions worth keeping (their result byte still unset).
+int playGame(Board& board, TranspositionTable& table, const DatagenOptions& options,
+             std::vector<PackedPosition>& records) {
+    for (int ply = 0;; ply++) {
+        std::vector<Move> moves = board.generateLegalMoves();
+        if (moves.empty()) {
+            if (board.inCheck())
+                return board.sideToMove == Piece::White ? 0 : 2;
+            return 1;
+        }
+        if (board.isThreefoldRepetition() || board.isFiftyMoveDraw() || insufficientMaterial(board) ||
+            ply >= MAX_GAME_PLIES)
+            return 1;
+
+        SearchLimits limits;
+        limits.nodes = options.nodes;
+        Search search(board, limits, &table);
+        search.setOutput([](const std::string&) {});
+        Move best = search.findBestMove();
+        int score = search.getScore();
+
+        bool quiet = best.capturePiece == Piece::None && !best.isEnPassant && !best.isPromotion &&
+                     !board.inCheck();
+        if (quiet && std::abs(score) <= MAX_RECORDED_SCORE) {
+            PackedPosition record;
+            packPosition(board, score, 0, record);
+            records.push_back(record);
+        }
+        board.makeMove(best);
+    }
+}
+
+void runWorker(const DatagenOptions& options, DatagenState& state, int workerIndex) {
+    std::mt19937 rng(options.seed * 7919u + workerIndex);
+    TranspositionTable table(TABLE_MB);
+    Board board;
+    std::vector<PackedPosition> records;
+    for (;;) {
+        int game = state.nextGame++;
+        if (game >= options.games)
+            break;
+
+        do {
+            board.fenPosition(START_FEN);
+        } while (!playRandomOpening(board, options.randomPlies, rng));
+        table.clear();
+        records.clear();
+        int result = playGame(board, table, options, records);
+        for (PackedPosition& record : records)
+            record.bytes[PACKED_POSITION_SIZE - 1] = static_cast<uint8_t>(result);
+
+        std::lock_guard<std::mutex> guard(state.lock);
+        state.out.write(reinterpret_cast<const char*>(records.data()), records.size() * PACKED_POSITION_SIZE);
+        state.positions += records.size();
+        state.finishedGames++;
+        if (state.finishedGames % REPORT_INTERVAL == 0 || state.finishedGames == options.games) {
+            long long elapsed = std::max(1LL, Search::clockMs() - state.startMs);
+            std::cout << "games " << state.finishedGames << " positions " << state.positions
+                      << " (" << state.positions * 1000 / elapsed << "/s)" << std::endl;
+        }
+    }
+}
+
+void printUsage() {
+    std::cerr <<
+        "usage: datagen --output FILE [options]\n"
+        "  --games N          games to play (default 1000)\n"
+        "  --threads N        games played at once (default: all cores)\n"
+        "  --nodes N          nodes searched per move (default 5000)\n"
+        "  --random-plies N   random moves at the start of each game (default 8)\n"
+        "  --seed S           seed for the random openings (default 1)\n"
+        "Records are appended to FILE.\n";
+}
+
+bool parseArguments(int argc, char** argv, DatagenOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+            return false;
+        if (arg == "--output")            options.outputFile = argv[++i];
+        else if (arg == "--games")        options.games = std::atoi(argv[++i]);
+        else if (arg == "--threads")      options.threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--nodes")        options.nodes = std::atoll(argv[++i]);
+        else if (arg == "--random-plies") options.randomPlies = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--seed")         options.seed = static_cast<unsigned>(std::atol(argv[++i]));
+        else return false;
+    }
+    return !options.outputFile.empty() && options.games > 0 && options.nodes > 0;
+}
+
+}
+
+int main(int argc, char** argv) {
+    DatagenOptions options;
+    if (!parseArguments(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    DatagenState state;
+    state.out.open(options.outputFile, std::ios::binary | std::ios::app);
+    if (!state.out) {
+        std::cerr << "cannot open " << options.outputFile << std::endl;
+        return 1;
+    }
+    state.startMs = Search::clockMs();
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < options.threads; i++)
+        workers.push_back(std::thread(runWorker, std::cref(options), std::ref(state), i));
+    for (std::thread& worker : workers)
+        worker.join();
+
+    state.out.close();
+    if (!state.out) {
+        std::cerr << "error writing " << options.outputFile << std::endl;
+        return 1;
+    }
+    return 0;
+}
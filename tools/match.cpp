@@ -0,0 +1,540 @@
+// Self-play match runner. Plays games between two UCI engines (two builds,
+// or one build under two option sets) and reports the Elo difference with a
+// sequential probability ratio test, so that a change can be accepted or
+// rejected on playing strength rather than speed alone.
+//
+//   make match
+//   ./match --engine1 ./chessEngine --engine2 ./baseline --openings book.epd
+//           --games 20000 --concurrency 8 --nodes 20000 --sprt 0 5
+//
+// Each opening is played twice with colors swapped. Games are adjudicated
+// by the runner's own Board: checkmate, stalemate, threefold repetition,
+// the fifty-move rule and insufficient material.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "../headers/board.h"
+#include "../headers/utils.h"
+
+namespace {
+
+// Games still running after this many plies are scored as draws.
+const int MAX_GAME_PLIES = 600;
+// Slack on the clock before a move counts as a loss on time.
+const int TIME_MARGIN_MS = 100;
+// With fixed nodes there is no clock; a move taking this long means a hang.
+const int NODE_MOVE_TIMEOUT_MS = 60000;
+const int HANDSHAKE_TIMEOUT_MS = 10000;
+const long long DEFAULT_NODES = 10000;
+
+struct EngineConfig {
+    std::string command;
+    std::vector<std::pair<std::string, std::string>> options;
+};
+
+struct MatchConfig {
+    EngineConfig engines[2];
+    std::string openingsFile;
+    int games = 1000;
+    int concurrency = 1;
+    long long nodes = 0;
+    int baseTimeMs = 0;
+    int incrementMs = 0;
+    double elo0 = 0, elo1 = 5;
+    double alpha = 0.05, beta = 0.05;
+};
+
+long long nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// A UCI engine running as a child process, spoken to through two pipes.
+class EngineProcess {
+public:
+    ~EngineProcess() { stop(); }
+
+    bool start(const EngineConfig& config) {
+        int toChild[2], fromChild[2];
+        if (pipe2(toChild, O_CLOEXEC) != 0)
+            return false;
+        if (pipe2(fromChild, O_CLOEXEC) != 0) {
+            ::close(toChild[0]);
+            ::close(toChild[1]);
+            return false;
+        }
+        pid = fork();
+        if (pid == 0) {
+            dup2(toChild[0], STDIN_FILENO);
+            dup2(fromChild[1], STDOUT_FILENO);
+            std::string command = "exec " + config.command;
+            execl("/bin/sh", "sh", "-c", command.c_str(), static_cast<char*>(nullptr));
+            _exit(127);
+        }
+        ::close(toChild[0]);
+        ::close(fromChild[1]);
+        toEngine = toChild[1];
+        fromEngine = fromChild[0];
+        buffer.clear();
+        if (pid < 0) {
+            stop();
+            return false;
+        }
+
+        std::string line;
+        if (!send("uci") || !waitFor("uciok", line, HANDSHAKE_TIMEOUT_MS)) {
+            stop();
+            return false;
+        }
+        for (const auto& option : config.options)
+            send("setoption name " + option.first + " value " + option.second);
+        return isReady();
+    }
+
+    void stop() {
+        if (toEngine >= 0) {
+            send("quit");
+            ::close(toEngine);
+            toEngine = -1;
+        }
+        if (fromEngine >= 0) {
+            ::close(fromEngine);
+            fromEngine = -1;
+        }
+        if (pid > 0) {
+            // Give the engine a moment to exit on its own before killing it.
+            bool exited = false;
+            for (int i = 0; i < 20 && !exited; i++) {
+                exited = waitpid(pid, nullptr, WNOHANG) == pid;
+                if (!exited)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            if (!exited) {
+                kill(pid, SIGKILL);
+                waitpid(pid, nullptr, 0);
+            }
+            pid = -1;
+        }
+    }
+
+    bool running() const { return pid > 0; }
+
+    bool send(const std::string& line) {
+        std::string data = line + '\n';
+        size_t written = 0;
+        while (written < data.size()) {
+            ssize_t n = write(toEngine, data.data() + written, data.size() - written);
+            if (n <= 0)
+                return false;
+            written += n;
+        }
+        return true;
+    }
+
+    // Reads one line. Fails at end of output or, when timeoutMs is positive,
+    // once that much time has passed.
+    bool readLine(std::string& line, int timeoutMs) {
+        long long deadline = nowMs() + timeoutMs;
+        for (;;) {
+            size_t newline = buffer.find('\n');
+            if (newline != std::string::npos) {
+                line = buffer.substr(0, newline);
+                buffer.erase(0, newline + 1);
+                if (!line.empty() && line.back() == '\r')
+                    line.pop_back();
+                return true;
+            }
+            int wait = -1;
+            if (timeoutMs > 0) {
+                long long left = deadline - nowMs();
+                if (left <= 0)
+                    return false;
+                wait = static_cast<int>(left);
+            }
+            pollfd pfd = {fromEngine, POLLIN, 0};
+            if (poll(&pfd, 1, wait) <= 0)
+                continue;
+            char chunk[4096];
+            ssize_t n = read(fromEngine, chunk, sizeof(chunk));
+            if (n <= 0)
+                return false;
+            buffer.append(chunk, n);
+        }
+    }
+
+    // Skips output until a line starting with the given word.
+    bool waitFor(const char* word, std::string& line, int timeoutMs) {
+        long long deadline = nowMs() + timeoutMs;
+        size_t length = std::string(word).size();
+        for (;;) {
+            int left = static_cast<int>(deadline - nowMs());
+            if (timeoutMs > 0 && left <= 0)
+                return false;
+            if (!readLine(line, timeoutMs > 0 ? left : 0))
+                return false;
+            if (line.compare(0, length, word) == 0 && (line.size() == length || line[length] == ' '))
+                return true;
+        }
+    }
+
+    bool isReady() {
+        std::string line;
+        return send("isready") && waitFor("readyok", line, HANDSHAKE_TIMEOUT_MS);
+    }
+
+private:
+    pid_t pid = -1;
+    int toEngine = -1;
+    int fromEngine = -1;
+    std::string buffer;
+};
+
+struct GameResult {
+    // From White's point of view: 2 win, 1 draw, 0 loss.
+    int whitePoints;
+    std::string reason;
+    // Index (0 White, 1 Black) of an engine that crashed or hung, else -1.
+    int failedSide;
+};
+
+GameResult playGame(EngineProcess* engines[2], const std::string& fen, const MatchConfig& config) {
+    Board board;
+    board.fenPosition(fen);
+    std::string moveList;
+    int clocks[2] = {config.baseTimeMs, config.baseTimeMs};
+    bool timed = config.baseTimeMs > 0;
+
+    for (int i = 0; i < 2; i++) {
+        engines[i]->send("ucinewgame");
+        if (!engines[i]->isReady())
+            return {i == 0 ? 0 : 2, "engine not ready", i};
+    }
+
+    for (int ply = 0;; ply++) {
+        int side = (board.sideToMove == Piece::White) ? 0 : 1;
+        int lossForSide = (side == 0) ? 0 : 2;
+
+        std::vector<Move> legalMoves = board.generateLegalMoves();
+        if (legalMoves.empty()) {
+            if (board.inCheck())
+                return {lossForSide, "checkmate", -1};
+            return {1, "stalemate", -1};
+        }
+        if (board.isFiftyMoveDraw())
+            return {1, "fifty-move rule", -1};
+        if (board.isThreefoldRepetition())
+            return {1, "threefold repetition", -1};
+        if (insufficientMaterial(board))
+            return {1, "insufficient material", -1};
+        if (ply >= MAX_GAME_PLIES)
+            return {1, "move limit", -1};
+
+        EngineProcess* engine = engines[side];
+        std::string position = "position fen " + fen;
+        if (!moveList.empty())
+            position += " moves" + moveList;
+        std::ostringstream go;
+        int timeoutMs = NODE_MOVE_TIMEOUT_MS;
+        if (timed) {
+            go << "go wtime " << clocks[0] << " btime " << clocks[1]
+               << " winc " << config.incrementMs << " binc " << config.incrementMs;
+            timeoutMs = clocks[side] + TIME_MARGIN_MS;
+        } else {
+            go << "go nodes " << config.nodes;
+        }
+
+        long long started = nowMs();
+        std::string line;
+        if (!engine->send(position) || !engine->send(go.str()))
+            return {lossForSide, "disconnected", side};
+        if (!engine->waitFor("bestmove", line, timeoutMs))
+            return {lossForSide, timed ? "loses on time" : "no move", side};
+        if (timed) {
+            clocks[side] -= static_cast<int>(nowMs() - started);
+            if (clocks[side] < -TIME_MARGIN_MS)
+                return {lossForSide, "loses on time", -1};
+            clocks[side] = std::max(clocks[side], 0) + config.incrementMs;
+        }
+
+        std::istringstream iss(line);
+        std::string token, text;
+        iss >> token >> text;
+        Move parsed;
+        const Move* played = nullptr;
+        if (parseUCIMove(board, text.c_str(), static_cast<int>(text.size()), parsed)) {
+            for (const Move& move : legalMoves) {
+                if (move.from == parsed.from && move.to == parsed.to &&
+                    move.promotionPiece == parsed.promotionPiece) {
+                    played = &move;
+                    break;
+                }
+            }
+        }
+        if (!played)
+            return {lossForSide, "illegal move " + text, -1};
+
+        board.makeMove(*played);
+        moveList += ' ' + text;
+    }
+}
+
+struct Tally {
+    int wins = 0, draws = 0, losses = 0;
+    int games() const { return wins + draws + losses; }
+};
+
+double eloFromScore(double score) {
+    return 400.0 * std::log10(score / (1.0 - score));
+}
+
+double scoreFromElo(double elo) {
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+// Elo estimate with a 95% error margin, from the mean and variance of the
+// per-game score.
+void eloEstimate(const Tally& tally, double& elo, double& margin) {
+    int n = tally.games();
+    elo = margin = 0;
+    if (n == 0)
+        return;
+    double w = double(tally.wins) / n, d = double(tally.draws) / n;
+    double score = w + d / 2;
+    double variance = w + d / 4 - score * score;
+    double deviation = std::sqrt(variance / n);
+    double low = std::min(std::max(score - 1.96 * deviation, 1e-6), 1 - 1e-6);
+    double high = std::min(std::max(score + 1.96 * deviation, 1e-6), 1 - 1e-6);
+    score = std::min(std::max(score, 1e-6), 1 - 1e-6);
+    elo = eloFromScore(score);
+    margin = (eloFromScore(high) - eloFromScore(low)) / 2;
+}
+
+// Log-likelihood ratio of H1 (elo = elo1) against H0 (elo = elo0), using
+// the normal approximation to the trinomial game outcome.
+double sprtLLR(const Tally& tally, double elo0, double elo1) {
+    int n = tally.games();
+    if (n == 0 || tally.wins == 0 || tally.losses == 0)
+        return 0;
+    double w = double(tally.wins) / n, d = double(tally.draws) / n;
+    double score = w + d / 2;
+    double variance = w + d / 4 - score * score;
+    if (variance <= 0)
+        return 0;
+    double s0 = scoreFromElo(elo0), s1 = scoreFromElo(elo1);
+    return n * (s1 - s0) * (2 * score - s0 - s1) / (2 * variance);
+}
+
+// Shared between the worker threads: the game counter, the running tally
+// from engine1's point of view, and the SPRT verdict.
+struct MatchState {
+    std::atomic<int> nextGame{0};
+    std::atomic<bool> finished{false};
+    std::mutex lock;
+    Tally tally;
+    int verdict = 0; // 1 H1 accepted, -1 H0 accepted
+    std::string error;
+};
+
+void recordGame(MatchState& state, const MatchConfig& config, int game, int points, const std::string& reason) {
+    std::lock_guard<std::mutex> guard(state.lock);
+    if (points == 2) state.tally.wins++;
+    else if (points == 1) state.tally.draws++;
+    else state.tally.losses++;
+
+    double elo, margin;
+    eloEstimate(state.tally, elo, margin);
+    double llr = sprtLLR(state.tally, config.elo0, config.elo1);
+    double lower = std::log(config.beta / (1 - config.alpha));
+    double upper = std::log((1 - config.beta) / config.alpha);
+
+    std::ostringstream out;
+    out.setf(std::ios::fixed);
+    out.precision(2);
+    const Tally& t = state.tally;
+    out << "Game " << (game + 1) << ": " << (points == 2 ? "win" : points == 1 ? "draw" : "loss")
+        << " (" << reason << ")  Score: " << t.wins << " - " << t.losses << " - " << t.draws
+        << "  Elo: " << elo << " +/- " << margin
+        << "  LLR: " << llr << " (" << lower << ", " << upper << ")\n";
+    std::cout << out.str() << std::flush;
+
+    if (state.verdict == 0) {
+        if (llr >= upper)
+            state.verdict = 1;
+        else if (llr <= lower)
+            state.verdict = -1;
+        if (state.verdict != 0)
+            state.finished = true;
+    }
+}
+
+void runWorker(const MatchConfig& config, const std::vector<std::string>& openings, MatchState& state) {
+    EngineProcess processes[2];
+    while (!state.finished) {
+        int game = state.nextGame++;
+        if (game >= config.games)
+            break;
+
+        for (int i = 0; i < 2; i++) {
+            if (!processes[i].running() && !processes[i].start(config.engines[i])) {
+                std::lock_guard<std::mutex> guard(state.lock);
+                state.error = "could not start engine: " + config.engines[i].command;
+                state.finished = true;
+                return;
+            }
+        }
+
+        // Both colors of an opening are played back to back.
+        const std::string& fen = openings[(game / 2) % openings.size()];
+        bool engine1White = (game % 2 == 0);
+        EngineProcess* players[2];
+        players[0] = engine1White ? &processes[0] : &processes[1];
+        players[1] = engine1White ? &processes[1] : &processes[0];
+
+        GameResult result = playGame(players, fen, config);
+        if (result.failedSide != -1) {
+            // Restart a crashed or hung engine before the next game.
+            int index = (result.failedSide == 0) == engine1White ? 0 : 1;
+            processes[index].stop();
+        }
+        int points = engine1White ? result.whitePoints : 2 - result.whitePoints;
+        recordGame(state, config, game, points, result.reason);
+    }
+}
+
+// EPD lines carry the first four FEN fields followed by opcodes.
+bool loadOpenings(const std::string& file, std::vector<std::string>& openings) {
+    std::ifstream in(file);
+    if (!in)
+        return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream iss(line);
+        std::string fields[4];
+        if (!(iss >> fields[0] >> fields[1] >> fields[2] >> fields[3]))
+            continue;
+        openings.push_back(fields[0] + ' ' + fields[1] + ' ' + fields[2] + ' ' + fields[3] + " 0 1");
+    }
+    return !openings.empty();
+}
+
+bool parseOption(const std::string& text, EngineConfig& engine) {
+    size_t equals = text.find('=');
+    if (equals == std::string::npos || equals == 0)
+        return false;
+    engine.options.push_back(std::make_pair(text.substr(0, equals), text.substr(equals + 1)));
+    return true;
+}
+
+// "10+0.1": base time and increment in seconds.
+bool parseTimeControl(const std::string& text, MatchConfig& config) {
+    size_t plus = text.find('+');
+    double base = std::atof(text.substr(0, plus).c_str());
+    double increment = (plus == std::string::npos) ? 0 : std::atof(text.substr(plus + 1).c_str());
+    config.baseTimeMs = static_cast<int>(base * 1000);
+    config.incrementMs = static_cast<int>(increment * 1000);
+    return config.baseTimeMs > 0;
+}
+
+void printUsage() {
+    std::cerr <<
+        "usage: match --engine1 CMD [--engine2 CMD] [options]\n"
+        "  --option1 NAME=VALUE   UCI option for engine1 (repeatable)\n"
+        "  --option2 NAME=VALUE   UCI option for engine2 (repeatable)\n"
+        "  --openings FILE        EPD file of opening positions\n"
+        "  --games N              maximum number of games (default 1000)\n"
+        "  --concurrency N        games played at once (default 1)\n"
+        "  --nodes N              fixed nodes per move (default 10000)\n"
+        "  --tc BASE+INC          time control in seconds instead of nodes\n"
+        "  --sprt ELO0 ELO1       SPRT hypotheses (default 0 5)\n"
+        "  --alpha A --beta B     SPRT error rates (default 0.05)\n"
+        "engine2 defaults to the engine1 command, to compare option sets.\n";
+}
+
+bool parseArguments(int argc, char** argv, MatchConfig& config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--engine1" && hasValue)        config.engines[0].command = argv[++i];
+        else if (arg == "--engine2" && hasValue)   config.engines[1].command = argv[++i];
+        else if (arg == "--option1" && hasValue) { if (!parseOption(argv[++i], config.engines[0])) return false; }
+        else if (arg == "--option2" && hasValue) { if (!parseOption(argv[++i], config.engines[1])) return false; }
+        else if (arg == "--openings" && hasValue)  config.openingsFile = argv[++i];
+        else if (arg == "--games" && hasValue)     config.games = std::atoi(argv[++i]);
+        else if (arg == "--concurrency" && hasValue) config.concurrency = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--nodes" && hasValue)     config.nodes = std::atoll(argv[++i]);
+        else if (arg == "--tc" && hasValue)      { if (!parseTimeControl(argv[++i], config)) return false; }
+        else if (arg == "--sprt" && i + 2 < argc) {
+            config.elo0 = std::atof(argv[++i]);
+            config.elo1 = std::atof(argv[++i]);
+        }
+        else if (arg == "--alpha" && hasValue)     config.alpha = std::atof(argv[++i]);
+        else if (arg == "--beta" && hasValue)      config.beta = std::atof(argv[++i]);
+        else return false;
+    }
+    if (config.engines[0].command.empty() || config.games <= 0)
+        return false;
+    if (config.engines[1].command.empty())
+        config.engines[1].command = config.engines[0].command;
+    if (config.baseTimeMs == 0 && config.nodes <= 0)
+        config.nodes = DEFAULT_NODES;
+    return config.elo0 < config.elo1 && config.alpha > 0 && config.beta > 0;
+}
+
+}
+
+int main(int argc, char** argv) {
+    MatchConfig config;
+    if (!parseArguments(argc, argv, config)) {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<std::string> openings;
+    if (config.openingsFile.empty()) {
+        openings.push_back(START_FEN);
+    } else if (!loadOpenings(config.openingsFile, openings)) {
+        std::cerr << "no openings read from " << config.openingsFile << std::endl;
+        return 1;
+    }
+
+    // A dead engine must not take the runner down with it.
+    signal(SIGPIPE, SIG_IGN);
+
+    MatchState state;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < config.concurrency; i++)
+        workers.push_back(std::thread(runWorker, std::cref(config), std::cref(openings), std::ref(state)));
+    for (std::thread& worker : workers)
+        worker.join();
+
+    if (!state.error.empty()) {
+        std::cerr << state.error << std::endl;
+        return 1;
+    }
+    double elo, margin;
+    eloEstimate(state.tally, elo, margin);
+    std::cout.setf(std::ios::fixed);
+    std::cout.precision(2);
+    std::cout << "Finished " << state.tally.games() << " games: Elo " << elo << " +/- " << margin << '\n';
+    if (state.verdict == 1)
+        std::cout << "SPRT: H1 accepted (elo >= " << config.elo1 << ")" << std::endl;
+    else if (state.verdict == -1)
+        std::cout << "SPRT: H0 accepted (elo <= " << config.elo0 << ")" << std::endl;
+    else
+        std::cout << "SPRT: inconclusive" << std::endl;
+    return 0;
+}
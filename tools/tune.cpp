@@ -0,0 +1,408 @@
+// Texel tuner for the evaluation tables. Loads labelled positions, fits the
+// EvalParams to the game results by minimizing the squared error of a
+// sigmoid of the evaluation, and writes the result as a new eval_tables.h.
+//
+//   make OPTIMIZE=1 tune
+//   ./tune --data positions.txt --output headers/eval_tables.h
+//
+// Each line of the data file is a FEN (the last two fields are optional)
+// followed by the game result from White's side: 1-0, 0-1, 1/2-1/2 or a
+// number such as 1.0, 0.5, 0. Quotes, brackets and semicolons around the
+// result are ignored, so "c9 "1-0";" EPD lines work as they are. Records
+// written by tools/datagen.cpp are read with --packed instead of --data.
+//
+// The evaluation is linear in its parameters, so each position is stored
+// only as the list of its pieces (two bytes each) and the gradient is exact.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include "../headers/board.h"
+#include "../headers/eval.h"
+#include "../headers/packed_position.h"
+
+namespace {
+
+// Positions whose features are checked against Evaluator::evaluate on load.
+const int CROSS_CHECK_POSITIONS = 1000;
+const int REPORT_INTERVAL = 50;
+
+// Flattened parameter vector: piece values, then the piece-square tables,
+// then the centre-pawn bonus.
+const int VALUE_BASE = 0;
+const int SQUARE_BASE = 7;
+const int CENTER_INDEX = SQUARE_BASE + 7 * 64;
+const int PARAM_COUNT = CENTER_INDEX + 1;
+const uint16_t BLACK_PIECE = 0x8000;
+const double LN10 = 2.302585092994046;
+
+// Labelled positions in a compact layout: every piece is one entry of
+// type * 64 + square from its own side, with the top bit set for Black.
+struct PositionSet {
+    std::vector<uint16_t> pieces;
+    std::vector<uint32_t> offsets;      // start of each position; one extra at the end
+    std::vector<int8_t> centerPawns;    // White minus Black bonus pawns, 0 after the opening
+    std::vector<uint8_t> results;       // half points for White: 0, 1 or 2
+
+    size_t size() const { return results.size(); }
+};
+
+struct TuneOptions {
+    std::string dataFile;
+    std::string packedFile;
+    std::string outputFile = "eval_tables.h";
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    int iterations = 500;
+    double rate = 1.0;
+    double k = 0;   // sigmoid scale; fitted to the data when not given
+};
+
+std::vector<double> paramsToVector(const EvalParams& params) {
+    std::vector<double> weights(PARAM_COUNT);
+    for (int type = 0; type < 7; type++) {
+        weights[VALUE_BASE + type] = params.pieceValue[type];
+        for (int square = 0; square < 64; square++)
+            weights[SQUARE_BASE + type * 64 + square] = params.pieceSquare[type][square];
+    }
+    weights[CENTER_INDEX] = params.centerPawnBonus;
+    return weights;
+}
+
+EvalParams vectorToParams(const std::vector<double>& weights) {
+    EvalParams params;
+    for (int type = 0; type < 7; type++) {
+        params.pieceValue[type] = static_cast<int>(std::lround(weights[VALUE_BASE + type]));
+        for (int square = 0; square < 64; square++)
+            params.pieceSquare[type][square] = static_cast<int>(std::lround(weights[SQUARE_BASE + type * 64 + square]));
+    }
+    params.centerPawnBonus = static_cast<int>(std::lround(weights[CENTER_INDEX]));
+    return params;
+}
+
+double linearEval(const PositionSet& set, size_t index, const std::vector<double>& weights) {
+    double score = set.centerPawns[index] * weights[CENTER_INDEX];
+    for (uint32_t i = set.offsets[index]; i < set.offsets[index + 1]; i++) {
+        uint16_t entry = set.pieces[i];
+        int feature = entry & ~BLACK_PIECE;
+        double value = weights[VALUE_BASE + feature / 64] + weights[SQUARE_BASE + feature];
+        score += (entry & BLACK_PIECE) ? -value : value;
+    }
+    return score;
+}
+
+// Mirrors the structure of Evaluator::evaluate.
+void addPosition(PositionSet& set, const Board& board, uint8_t result) {
+    int center = 0;
+    bool opening = board.moveCount < Evaluator::OPENING_PLIES;
+    for (int i = 0; i < 64; i++) {
+        int code = board.board[i];
+        if (code == Piece::None)
+            continue;
+        int type = code & 7;
+        bool white = (code & Piece::White) != 0;
+        int relative = white ? i : i ^ 56;
+        set.pieces.push_back(static_cast<uint16_t>((type * 64 + relative) | (white ? 0 : BLACK_PIECE)));
+        if (opening && type == Piece::Pawn && relative / 8 < 6 && (relative % 8 == 3 || relative % 8 == 4))
+            center += white ? 1 : -1;
+    }
+    set.offsets.push_back(static_cast<uint32_t>(set.pieces.size()));
+    set.centerPawns.push_back(static_cast<int8_t>(center));
+    set.results.push_back(result);
+}
+
+// Adds the position, checking the first few against Evaluator::evaluate.
+bool addChecked(PositionSet& set, const Board& board, uint8_t result, const std::vector<double>& defaults) {
+    addPosition(set, board, result);
+    size_t index = set.size() - 1;
+    if (index < CROSS_CHECK_POSITIONS &&
+        std::lround(linearEval(set, index, defaults)) != Evaluator::evaluate(board)) {
+        std::cerr << "tuner features disagree with Evaluator::evaluate at position " << index + 1 << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool isInteger(const std::string& token) {
+    return !token.empty() && token.find_first_not_of("0123456789") == std::string::npos;
+}
+
+bool parseResult(std::string token, uint8_t& result) {
+    token.erase(std::remove_if(token.begin(), token.end(),
+                               [](char c) { return c == '"' || c == '[' || c == ']' || c == ';'; }),
+                token.end());
+    if (token == "1-0") { result = 2; return true; }
+    if (token == "0-1") { result = 0; return true; }
+    if (token == "1/2-1/2") { result = 1; return true; }
+    char* end = nullptr;
+    double value = std::strtod(token.c_str(), &end);
+    if (token.empty() || *end != '\0' || (value != 0 && value != 0.5 && value != 1))
+        return false;
+    result = static_cast<uint8_t>(value * 2);
+    return true;
+}
+
+bool loadPositions(const std::string& file, PositionSet& set, const std::vector<double>& defaults) {
+    std::ifstream in(file);
+    if (!in) {
+        std::cerr << "cannot open " << file << std::endl;
+        return false;
+    }
+    Board board;
+    std::string line;
+    size_t skipped = 0;
+    set.offsets.push_back(0);
+    while (std::getline(in, line)) {
+        std::istringstream iss(line);
+        std::vector<std::string> tokens;
+        std::string token;
+        while (iss >> token)
+            tokens.push_back(token);
+        uint8_t result;
+        if (tokens.size() < 5 || !parseResult(tokens.back(), result)) {
+            skipped++;
+            continue;
+        }
+        // The clocks, if present, sit between the FEN's fourth field and the result.
+        std::string fen = tokens[0] + ' ' + tokens[1] + ' ' + tokens[2] + ' ' + tokens[3];
+        for (size_t i = 4; i < tokens.size() - 1 && i < 6 && isInteger(tokens[i]); i++)
+            fen += ' ' + tokens[i];
+        board.fenPosition(fen);
+        if (!addChecked(set, board, result, defaults))
+            return false;
+    }
+    if (skipped > 0)
+        std::cerr << "skipped " << skipped << " unreadable lines" << std::endl;
+    return set.size() > 0;
+}
+
+bool loadPackedPositions(const std::string& file, PositionSet& set, const std::vector<double>& defaults) {
+    PackedPositionReader reader(file);
+    if (!reader.isOpen()) {
+        std::cerr << "cannot open " << file << std::endl;
+        return false;
+    }
+    Board board;
+    int score, result;
+    set.offsets.push_back(0);
+    while (reader.next(board, score, result)) {
+        if (!addChecked(set, board, static_cast<uint8_t>(result), defaults))
+            return false;
+    }
+    return set.size() > 0;
+}
+
+double sigmoid(double k, double score) {
+    return 1.0 / (1.0 + std::exp(-k * score * LN10 / 400.0));
+}
+
+// Mean squared error over the set and, if gradient is given, its gradient
+// with respect to the weights. The positions are split across threads, each
+// summing into its own buffers.
+double meanError(const PositionSet& set, const std::vector<double>& weights, double k,
+                 int threadCount, std::vector<double>* gradient) {
+    std::vector<double> errors(threadCount, 0.0);
+    std::vector<std::vector<double>> gradients(threadCount);
+    std::vector<std::thread> threads;
+    size_t chunk = (set.size() + threadCount - 1) / threadCount;
+
+    for (int t = 0; t < threadCount; t++) {
+        threads.push_back(std::thread([&, t]() {
+            size_t begin = t * chunk, end = std::min(set.size(), begin + chunk);
+            if (gradient)
+                gradients[t].assign(PARAM_COUNT, 0.0);
+            double error = 0;
+            for (size_t p = begin; p < end; p++) {
+                double predicted = sigmoid(k, linearEval(set, p, weights));
+                double diff = set.results[p] * 0.5 - predicted;
+                error += diff * diff;
+                if (!gradient)
+                    continue;
+                // d(diff^2)/d(score) = -2 diff * sigmoid'(score)
+                double slope = -2.0 * diff * predicted * (1 - predicted) * k * LN10 / 400.0;
+                gradients[t][CENTER_INDEX] += slope * set.centerPawns[p];
+                for (uint32_t i = set.offsets[p]; i < set.offsets[p + 1]; i++) {
+                    uint16_t entry = set.pieces[i];
+                    int feature = entry & ~BLACK_PIECE;
+                    double signedSlope = (entry & BLACK_PIECE) ? -slope : slope;
+                    gradients[t][VALUE_BASE + feature / 64] += signedSlope;
+                    gradients[t][SQUARE_BASE + feature] += signedSlope;
+                }
+            }
+            errors[t] = error;
+        }));
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    double total = 0;
+    for (double error : errors)
+        total += error;
+    if (gradient) {
+        gradient->assign(PARAM_COUNT, 0.0);
+        for (const std::vector<double>& partial : gradients)
+            for (int i = 0; i < PARAM_COUNT && !partial.empty(); i++)
+                (*gradient)[i] += partial[i] / set.size();
+    }
+    return total / set.size();
+}
+
+// Golden-section search for the sigmoid scale that best fits the current
+// evaluation, so the tuning starts from a calibrated error.
+double fitK(const PositionSet& set, const std::vector<double>& weights, int threads) {
+    const double ratio = (std::sqrt(5.0) - 1) / 2;
+    double low = 0.05, high = 5.0;
+    double a = high - ratio * (high - low), b = low + ratio * (high - low);
+    double errorA = meanError(set, weights, a, threads, nullptr);
+    double errorB = meanError(set, weights, b, threads, nullptr);
+    for (int i = 0; i < 40; i++) {
+        if (errorA < errorB) {
+            high = b; b = a; errorB = errorA;
+            a = high - ratio * (high - low);
+            errorA = meanError(set, weights, a, threads, nullptr);
+        } else {
+            low = a; a = b; errorA = errorB;
+            b = low + ratio * (high - low);
+            errorB = meanError(set, weights, b, threads, nullptr);
+        }
+    }
+    return (low + high) / 2;
+}
+
+// Weights that do not change the evaluation: the unused None entries and the
+// king's value, which both sides always have.
+bool isFrozen(int index) {
+    return index == VALUE_BASE + Piece::None || index == VALUE_BASE + Piece::King ||
+           (index >= SQUARE_BASE && index < SQUARE_BASE + 64);
+}
+
+// Gradient descent with Adam step sizes; rate is roughly the largest step
+// per iteration in centipawns.
+void tune(const PositionSet& set, std::vector<double>& weights, const TuneOptions& options, double k) {
+    const double beta1 = 0.9, beta2 = 0.999, epsilon = 1e-8;
+    std::vector<double> gradient, momentum(PARAM_COUNT, 0.0), velocity(PARAM_COUNT, 0.0);
+    for (int iteration = 1; iteration <= options.iterations; iteration++) {
+        double error = meanError(set, weights, k, options.threads, &gradient);
+        for (int i = 0; i < PARAM_COUNT; i++) {
+            if (isFrozen(i))
+                continue;
+            momentum[i] = beta1 * momentum[i] + (1 - beta1) * gradient[i];
+            velocity[i] = beta2 * velocity[i] + (1 - beta2) * gradient[i] * gradient[i];
+            double m = momentum[i] / (1 - std::pow(beta1, iteration));
+            double v = velocity[i] / (1 - std::pow(beta2, iteration));
+            weights[i] -= options.rate * m / (std::sqrt(v) + epsilon);
+        }
+        if (iteration % REPORT_INTERVAL == 0 || iteration == options.iterations)
+            std::cout << "iteration " << iteration << " error " << error << std::endl;
+    }
+}
+
+bool writeTables(const std::string& file, const EvalParams& params, const std::string& source) {
+    static const char* names[7] = {"None", "King", "Pawn", "Knight", "Bishop", "Rook", "Queen"};
+    std::ofstream out(file);
+    if (!out)
+        return false;
+    out << "// Evaluation tables, indexed by Piece::Type. Piece-square values are given\n"
+           "// from White's side (square 0 is a8); Black's pieces read them mirrored.\n"
+           "//\n"
+           "// Written by tools/tune.cpp; regenerate with the tuner instead of editing.\n"
+           "// Source: " << source << "\n"
+           "\n"
+           "#ifndef EVAL_TABLES_H\n"
+           "#define EVAL_TABLES_H\n"
+           "\n"
+           "const int EVAL_PIECE_VALUES[7] = {";
+    for (int type = 0; type < 7; type++)
+        out << (type ? ", " : "") << params.pieceValue[type];
+    out << "};\n\nconst int EVAL_PIECE_SQUARE[7][64] = {\n";
+    for (int type = 0; type < 7; type++) {
+        out << "    { // " << names[type] << '\n';
+        for (int rank = 0; rank < 8; rank++) {
+            out << "        ";
+            for (int file = 0; file < 8; file++) {
+                char cell[16];
+                std::snprintf(cell, sizeof(cell), "%4d", params.pieceSquare[type][rank * 8 + file]);
+                out << cell << (file < 7 ? ", " : "");
+            }
+            out << (rank < 7 ? ",\n" : "\n");
+        }
+        out << "    }" << (type < 6 ? ",\n" : "\n");
+    }
+    out << "};\n"
+           "\n"
+           "// For each d- or e-pawn off its start square during the first 20 plies.\n"
+           "const int EVAL_CENTER_PAWN_BONUS = " << params.centerPawnBonus << ";\n"
+           "\n"
+           "#endif\n";
+    return static_cast<bool>(out);
+}
+
+void printUsage() {
+    std::cerr <<
+        "usage: tune --data FILE | --packed FILE [options]\n"
+        "  --output FILE      header to write (default eval_tables.h)\n"
+        "  --threads N        worker threads (default: all cores)\n"
+        "  --iterations N     gradient steps (default 500)\n"
+        "  --rate R           step size in centipawns (default 1.0)\n"
+        "  --k K              sigmoid scale (default: fitted to the data)\n";
+}
+
+bool parseArguments(int argc, char** argv, TuneOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+            return false;
+        if (arg == "--data")            options.dataFile = argv[++i];
+        else if (arg == "--packed")     options.packedFile = argv[++i];
+        else if (arg == "--output")     options.outputFile = argv[++i];
+        else if (arg == "--threads")    options.threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--iterations") options.iterations = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--rate")       options.rate = std::atof(argv[++i]);
+        else if (arg == "--k")          options.k = std::atof(argv[++i]);
+        else return false;
+    }
+    return options.dataFile.empty() != options.packedFile.empty() && options.rate > 0;
+}
+
+}
+
+int main(int argc, char** argv) {
+    TuneOptions options;
+    if (!parseArguments(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<double> weights = paramsToVector(Evaluator::defaultParams());
+    PositionSet set;
+    bool loaded = options.packedFile.empty() ? loadPositions(options.dataFile, set, weights)
+                                             : loadPackedPositions(options.packedFile, set, weights);
+    if (!loaded)
+        return 1;
+    size_t bytes = set.pieces.size() * sizeof(uint16_t) + set.offsets.size() * sizeof(uint32_t) +
+                   set.centerPawns.size() + set.results.size();
+    std::cout << "loaded " << set.size() << " positions, " << bytes / set.size() << " bytes each" << std::endl;
+
+    double k = options.k > 0 ? options.k : fitK(set, weights, options.threads);
+    std::cout << "k " << k << " initial error " << meanError(set, weights, k, options.threads, nullptr) << std::endl;
+
+    tune(set, weights, options, k);
+
+    EvalParams tuned = vectorToParams(weights);
+    std::ostringstream source;
+    source << set.size() << " positions from "
+           << (options.packedFile.empty() ? options.dataFile : options.packedFile) << ", k = " << k;
+    if (!writeTables(options.outputFile, tuned, source.str())) {
+        std::cerr << "cannot write " << options.outputFile << std::endl;
+        return 1;
+    }
+    std::cout << "wrote " << options.outputFile << std::endl;
+    return 0;
+}